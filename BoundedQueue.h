@@ -0,0 +1,96 @@
+//
+// class BoundedQueue
+//
+
+#ifndef SUDOKU_BOUNDEDQUEUE_H
+#define SUDOKU_BOUNDEDQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// A fixed-capacity lock-free queue for any number of producers and consumers (D. Vyukov's bounded MPMC queue).
+// Every cell has a sequence number telling whether it is ready to be written or read in the current lap of the ring,
+// so producers and consumers only contend on their own position counter. Operations never block: they fail when the
+// queue is full or empty, and the caller decides how to wait
+template<typename T>
+class BoundedQueue {
+public:
+   // @p capacity is rounded up to a power of 2, and to at least 2: with a single cell, the sequence number telling that
+   // it can be read at some position would also tell that it can be written at the next one
+   explicit BoundedQueue(std::size_t capacity) {
+      std::size_t num_cells = 2;
+      while (num_cells < capacity) {
+         num_cells *= 2;
+      }
+      _cells = std::make_unique<Cell[]>(num_cells);
+      for (std::size_t idx = 0; idx != num_cells; ++idx) {
+         _cells[idx].sequence.store(idx, std::memory_order_relaxed);
+      }
+      _mask = num_cells - 1;
+   }
+
+   BoundedQueue(const BoundedQueue &) = delete;
+
+   BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+   // Appends @p value, moving from it. Returns false (leaving @p value untouched) if the queue is full
+   bool try_push(T &value) {
+      std::size_t pos = _push_pos.load(std::memory_order_relaxed);
+      Cell *cell;
+      while (true) {
+         cell = &_cells[pos & _mask];
+         auto lag = static_cast<std::intptr_t>(cell->sequence.load(std::memory_order_acquire) - pos);
+         if (lag == 0) {
+            if (_push_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+               break;
+            }
+         } else if (lag < 0) {
+            return false;
+         } else {
+            pos = _push_pos.load(std::memory_order_relaxed);
+         }
+      }
+      cell->value = std::move(value);
+      cell->sequence.store(pos + 1, std::memory_order_release);
+      return true;
+   }
+
+   // Moves the oldest value into @p value. Returns false if the queue is empty
+   bool try_pop(T &value) {
+      std::size_t pos = _pop_pos.load(std::memory_order_relaxed);
+      Cell *cell;
+      while (true) {
+         cell = &_cells[pos & _mask];
+         auto lag = static_cast<std::intptr_t>(cell->sequence.load(std::memory_order_acquire) - (pos + 1));
+         if (lag == 0) {
+            if (_pop_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+               break;
+            }
+         } else if (lag < 0) {
+            return false;
+         } else {
+            pos = _pop_pos.load(std::memory_order_relaxed);
+         }
+      }
+      value = std::move(cell->value);
+      cell->sequence.store(pos + _mask + 1, std::memory_order_release);
+      return true;
+   }
+
+   std::size_t capacity() const { return _mask + 1; }
+
+private:
+   struct Cell {
+      std::atomic<std::size_t> sequence;  // pos if the cell can be written at pos, pos + 1 if it can be read at pos
+      T value;
+   };
+
+   std::unique_ptr<Cell[]> _cells;
+   std::size_t _mask;  // the number of cells minus 1
+   alignas(64) std::atomic<std::size_t> _push_pos{0};  // the position of the next push (on its own cache line)
+   alignas(64) std::atomic<std::size_t> _pop_pos{0};  // the position of the next pop
+};
+
+#endif //SUDOKU_BOUNDEDQUEUE_H
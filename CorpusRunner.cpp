@@ -0,0 +1,280 @@
+//
+// Implementation file for the sharded solving of puzzle corpora
+//
+
+#include "CorpusRunner.h"
+#include "ParallelWork.h"
+#include "PuzzleCorpus.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+   const char MANIFEST_TAG[] = "sudoku-corpus-run";
+   const unsigned int MANIFEST_VERSION = 1;
+   const std::size_t FINGERPRINT_BYTES = 1u << 16;  // the length of the beginning of the input that is hashed
+
+   // A finished shard, as recorded in the manifest
+   struct ShardResult {
+      std::uint64_t num_puzzles = 0;
+      std::uint64_t num_solved = 0;
+      double seconds = 0;
+   };
+
+   // The puzzles of an input file, split in shards of consecutive puzzles. Shards can be solved from any thread
+   class ShardedInput {
+   public:
+      ShardedInput(const std::string &path, std::uint64_t shard_bytes);
+
+      std::uint64_t num_shards() const { return _boundaries.size() - 1; }
+
+      std::uint64_t file_bytes() const { return _file.size(); }
+
+      // A hash of the beginning of the file, to recognize the input of an interrupted run (FNV-1a)
+      std::uint64_t fingerprint() const {
+         std::uint64_t hash = 0xCBF29CE484222325ull;
+         for (std::size_t idx = 0; idx != std::min(_file.size(), FINGERPRINT_BYTES); ++idx) {
+            hash = (hash ^ _file.data()[idx]) * 0x100000001B3ull;
+         }
+         return hash;
+      }
+
+      // Solves the puzzles of the shard @p shard_idx, writing a line for each of them to @p output
+      ShardResult solve_shard(std::uint64_t shard_idx, std::ostream &output) const;
+
+   private:
+      ShardResult solve_text_shard(std::uint64_t shard_idx, std::ostream &output) const;
+
+      ShardResult solve_corpus_shard(std::uint64_t shard_idx, std::ostream &output) const;
+
+      MappedFile _file;
+      std::unique_ptr<PuzzleCorpus> _corpus;  // the records of the input if it is a corpus, null for a text file
+      // where each shard starts (a byte offset in a text file, a record index in a corpus), then where the last ends
+      std::vector<std::uint64_t> _boundaries;
+   };
+
+   ShardedInput::ShardedInput(const std::string &path, std::uint64_t shard_bytes) : _file{path} {
+      shard_bytes = std::max<std::uint64_t>(shard_bytes, 1);
+      _boundaries.push_back(0);
+      if (PuzzleCorpus::is_corpus_file(path)) {
+         _corpus = std::make_unique<PuzzleCorpus>(path);
+         check_one_line_size(_corpus->get_size());
+         std::uint64_t records_per_shard = std::max<std::uint64_t>(shard_bytes / _corpus->stride(), 1);
+         while (_boundaries.back() != _corpus->count()) {
+            _boundaries.push_back(std::min(_boundaries.back() + records_per_shard, _corpus->count()));
+         }
+         return;
+      }
+
+      // every shard but the first starts after the first end of line at or after its nominal offset
+      const auto *text = reinterpret_cast<const char *>(_file.data());
+      for (std::uint64_t offset = shard_bytes; offset < _file.size(); offset += shard_bytes) {
+         const void *line_end = std::memchr(text + offset - 1, '\n', _file.size() - (offset - 1));
+         std::uint64_t shard_begin = line_end ? static_cast<const char *>(line_end) - text + 1 : _file.size();
+         _boundaries.push_back(std::max(shard_begin, _boundaries.back()));
+      }
+      if (_file.size() != 0) {
+         _boundaries.push_back(_file.size());
+      }
+   }
+
+   ShardResult ShardedInput::solve_shard(std::uint64_t shard_idx, std::ostream &output) const {
+      return _corpus ? solve_corpus_shard(shard_idx, output) : solve_text_shard(shard_idx, output);
+   }
+
+   ShardResult ShardedInput::solve_text_shard(std::uint64_t shard_idx, std::ostream &output) const {
+      ShardResult result;
+      std::vector<unsigned int> tiles, solution;
+      std::string line;
+      const auto *text = reinterpret_cast<const char *>(_file.data());
+      const char *shard_end = text + _boundaries[shard_idx + 1];
+      for (const char *line_begin = text + _boundaries[shard_idx]; line_begin != shard_end;) {
+         const auto *line_end = static_cast<const char *>(std::memchr(line_begin, '\n', shard_end - line_begin));
+         if (not line_end) {
+            line_end = shard_end;
+         }
+         if (not is_blank_line(line_begin, line_end)) {
+            line.clear();
+            const char *field = line_begin;
+            unsigned int size = read_one_line_field(field, line_end, tiles);
+            if (size == 0) {
+               format_unreadable_line(line_begin, line_end, line);
+            } else {
+               bool is_solved = solve_puzzle(tiles, solution);
+               format_solution_line(tiles.data(), is_solved ? solution.data() : nullptr, size, line);
+               result.num_solved += is_solved;
+            }
+            output << line;
+            ++result.num_puzzles;
+         }
+         line_begin = line_end == shard_end ? shard_end : line_end + 1;
+      }
+      return result;
+   }
+
+   ShardResult ShardedInput::solve_corpus_shard(std::uint64_t shard_idx, std::ostream &output) const {
+      ShardResult result;
+      std::vector<unsigned int> tiles, solution;
+      std::string line;
+      for (std::uint64_t record_idx = _boundaries[shard_idx]; record_idx != _boundaries[shard_idx + 1]; ++record_idx) {
+         PuzzleRecord record = _corpus->puzzle(record_idx);
+         tiles.resize(record.num_tiles());
+         record.unpack(tiles.data());
+         bool is_solved = solve_puzzle(record, solution);
+         line.clear();
+         format_solution_line(tiles.data(), is_solved ? solution.data() : nullptr, record.get_size(), line);
+         result.num_solved += is_solved;
+         output << line;
+         ++result.num_puzzles;
+      }
+      return result;
+   }
+
+   std::filesystem::path shard_path(const std::filesystem::path &output_dir, std::uint64_t shard_idx) {
+      std::ostringstream name;
+      name << "shard_" << std::setw(6) << std::setfill('0') << shard_idx << ".txt";
+      return output_dir / name.str();
+   }
+
+   void merge_shards(const std::filesystem::path &output_dir, std::uint64_t num_shards) {
+      std::filesystem::path merged_path = output_dir / "solutions.txt";
+      std::filesystem::path temporary_path = output_dir / "solutions.txt.tmp";
+      std::ofstream merged(temporary_path, std::ios::binary | std::ios::trunc);
+      for (std::uint64_t shard_idx = 0; shard_idx != num_shards; ++shard_idx) {
+         std::ifstream shard_file(shard_path(output_dir, shard_idx), std::ios::binary);
+         if (not shard_file.is_open()) {
+            throw std::invalid_argument("Cannot open the file \"" + shard_path(output_dir, shard_idx).string() + "\"");
+         }
+         // inserting an empty buffer would set the failbit of the output
+         if (shard_file.peek() != std::ifstream::traits_type::eof()) {
+            merged << shard_file.rdbuf();
+         }
+      }
+      merged.close();
+      if (not merged) {
+         throw std::invalid_argument("Cannot write the file \"" + temporary_path.string() + "\"");
+      }
+      std::filesystem::rename(temporary_path, merged_path);
+   }
+}
+
+CorpusRunReport run_corpus(const std::string &input_path, const std::string &output_dir,
+                           const CorpusRunOptions &options) {
+   auto start = std::chrono::steady_clock::now();
+   std::filesystem::path dir{output_dir};
+   std::filesystem::create_directories(dir);
+   std::filesystem::path manifest_path = dir / "manifest.txt";
+
+   // the manifest starts with the identity of the input and the shard length, then has a line per finished shard
+   std::ifstream recorded_manifest(manifest_path);
+   bool is_resumed = recorded_manifest.is_open();
+   std::uint64_t file_bytes = 0, fingerprint = 0, shard_bytes = options.shard_bytes, num_shards = 0;
+   std::string line;
+   if (is_resumed) {
+      std::string tag;
+      unsigned int version = 0;
+      std::getline(recorded_manifest, line);
+      std::istringstream header{line};
+      if (not(header >> tag >> version >> file_bytes >> fingerprint >> shard_bytes >> num_shards) or
+          tag != MANIFEST_TAG or version != MANIFEST_VERSION) {
+         throw std::invalid_argument("The file \"" + manifest_path.string() + "\" is not the manifest of a corpus run");
+      }
+   }
+   ShardedInput input(input_path, shard_bytes);
+   if (is_resumed and (file_bytes != input.file_bytes() or fingerprint != input.fingerprint() or
+                       num_shards != input.num_shards())) {
+      throw std::invalid_argument("The directory \"" + output_dir + "\" holds the run of a different input");
+   }
+
+   CorpusRunReport report;
+   report.num_shards = input.num_shards();
+   std::vector<ShardResult> results(report.num_shards);
+   std::vector<char> is_finished(report.num_shards, 0);
+   while (std::getline(recorded_manifest, line)) {
+      // a shard is finished only if its line is complete (the last one may have been cut by an interruption)
+      std::istringstream shard_line{line};
+      std::string tag;
+      std::uint64_t shard_idx = 0;
+      ShardResult result;
+      if (shard_line >> tag >> shard_idx >> result.num_puzzles >> result.num_solved >> result.seconds and
+          tag == "shard" and shard_idx < report.num_shards and
+          std::filesystem::exists(shard_path(dir, shard_idx))) {
+         results[shard_idx] = result;
+         is_finished[shard_idx] = 1;
+      }
+   }
+   recorded_manifest.close();
+
+   std::ofstream manifest(manifest_path, std::ios::app);
+   if (not manifest.is_open()) {
+      throw std::invalid_argument("Cannot create the file \"" + manifest_path.string() + "\"");
+   }
+   if (not is_resumed) {
+      manifest << MANIFEST_TAG << ' ' << MANIFEST_VERSION << ' ' << input.file_bytes() << ' ' << input.fingerprint()
+               << ' ' << shard_bytes << ' ' << input.num_shards() << std::endl;
+   }
+
+   std::vector<std::uint64_t> pending_shards;
+   for (std::uint64_t shard_idx = 0; shard_idx != report.num_shards; ++shard_idx) {
+      if (not is_finished[shard_idx]) {
+         pending_shards.push_back(shard_idx);
+      }
+   }
+   report.num_resumed_shards = report.num_shards - pending_shards.size();
+   if (pending_shards.size() > options.max_shards) {
+      pending_shards.resize(options.max_shards);
+   }
+
+   std::mutex manifest_mutex;
+   run_workers(options.num_threads, pending_shards.size(), [&](unsigned int, std::uint64_t pos) {
+      std::uint64_t shard_idx = pending_shards[pos];
+      auto shard_start = std::chrono::steady_clock::now();
+      std::filesystem::path temporary_path = shard_path(dir, shard_idx);
+      temporary_path += ".tmp";
+      std::ofstream shard_file(temporary_path, std::ios::binary | std::ios::trunc);
+      if (not shard_file.is_open()) {
+         throw std::invalid_argument("Cannot create the file \"" + temporary_path.string() + "\"");
+      }
+      ShardResult result = input.solve_shard(shard_idx, shard_file);
+      shard_file.close();
+      if (not shard_file) {
+         throw std::invalid_argument("Cannot write the file \"" + temporary_path.string() + "\"");
+      }
+      std::filesystem::rename(temporary_path, shard_path(dir, shard_idx));
+      result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - shard_start).count();
+
+      std::lock_guard<std::mutex> lock(manifest_mutex);
+      manifest << "shard " << shard_idx << ' ' << result.num_puzzles << ' ' << result.num_solved << ' '
+               << result.seconds << std::endl;
+      results[shard_idx] = result;
+      is_finished[shard_idx] = 1;
+      report.num_puzzles_this_run += result.num_puzzles;
+   });
+
+   for (std::uint64_t shard_idx = 0; shard_idx != report.num_shards; ++shard_idx) {
+      if (is_finished[shard_idx]) {
+         ++report.num_finished_shards;
+         report.num_puzzles += results[shard_idx].num_puzzles;
+         report.num_solved += results[shard_idx].num_solved;
+         report.shard_seconds += results[shard_idx].seconds;
+      }
+   }
+   if (report.is_complete()) {
+      // a run that only finds finished shards keeps the merged output of the run that finished them
+      if (not pending_shards.empty() or not std::filesystem::exists(dir / "solutions.txt")) {
+         merge_shards(dir, report.num_shards);
+      }
+      report.is_merged = true;
+   }
+   report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   return report;
+}
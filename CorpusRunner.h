@@ -0,0 +1,54 @@
+//
+// Sharded and resumable solving of large puzzle corpora
+//
+// The input (a corpus file or a text file in the one-line format) is split into shards of consecutive puzzles:
+// a shard of a text file is a byte range starting and ending at line boundaries, a shard of a corpus a range of
+// whole records. Shards are solved in parallel, each into its own file of the output directory:
+//
+//    shard_NNNNNN.txt   the solutions of shard NNNNNN, one "puzzle,solution" line per puzzle in input order
+//                       ("puzzle," if the puzzle cannot be solved or read); blank lines of a text file are skipped
+//    manifest.txt       the checkpoint: the identity of the input and the shards finished so far
+//    solutions.txt      the shard files merged in order, written once every shard is finished
+//
+// A shard file is written under a temporary name and renamed before its line is added to the manifest, so a run
+// interrupted at any point can be resumed by running it again on the same directory: finished shards are skipped.
+//
+
+#ifndef SUDOKU_CORPUSRUNNER_H
+#define SUDOKU_CORPUSRUNNER_H
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+// The settings of a corpus run
+struct CorpusRunOptions {
+   unsigned int num_threads = 0;  // the number of shards solved at the same time, 0 means one per core
+   std::uint64_t shard_bytes = 1u << 22;  // the approximate length of the input in a shard, fixed by the first run
+   std::uint64_t max_shards = std::numeric_limits<std::uint64_t>::max();  // the shards to solve before stopping
+};
+
+// The outcome of a corpus run. The puzzle counts cover every finished shard, including those of earlier runs
+struct CorpusRunReport {
+   std::uint64_t num_shards = 0;
+   std::uint64_t num_finished_shards = 0;
+   std::uint64_t num_resumed_shards = 0;  // the shards finished by earlier runs, skipped by this one
+   std::uint64_t num_puzzles = 0;
+   std::uint64_t num_solved = 0;
+   std::uint64_t num_puzzles_this_run = 0;
+   double shard_seconds = 0;  // the total time spent solving the finished shards, by all the threads of all the runs
+   double seconds = 0;  // the wall-clock time of this run
+   bool is_merged = false;  // tells if solutions.txt has been written
+
+   bool is_complete() const { return num_finished_shards == num_shards; }
+
+   double puzzles_per_second() const { return seconds > 0 ? static_cast<double>(num_puzzles_this_run) / seconds : 0; }
+};
+
+// Solves the puzzles of @p input_path shard by shard into the directory @p output_dir (created if needed), resuming
+// the run recorded there if any. At most @p options.max_shards unfinished shards are solved; when no shard is left
+// the output is merged. Throws std::invalid_argument if the directory holds the run of a different input
+CorpusRunReport run_corpus(const std::string &input_path, const std::string &output_dir,
+                           const CorpusRunOptions &options);
+
+#endif //SUDOKU_CORPUSRUNNER_H
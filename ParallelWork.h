@@ -0,0 +1,62 @@
+//
+// Running independent work items on a pool of threads
+//
+
+#ifndef SUDOKU_PARALLELWORK_H
+#define SUDOKU_PARALLELWORK_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// The number of workers used by run_workers for @p num_items items on @p num_threads threads (0 means one per core):
+// never more than the items, and at least one
+inline unsigned int worker_count(unsigned int num_threads, std::uint64_t num_items) {
+   if (num_threads == 0) {
+      num_threads = std::max(1u, std::thread::hardware_concurrency());
+   }
+   return static_cast<unsigned int>(std::max<std::uint64_t>(std::min<std::uint64_t>(num_threads, num_items), 1));
+}
+
+// Calls @p work(worker_idx, item_idx) for every item_idx in [0, @p num_items), on worker_count(num_threads, num_items)
+// workers: the calling thread is worker 0, the others run on their own threads. Each free worker takes the next item,
+// so the calls of a worker have increasing item_idx. Once a call throws, no other item is started, and the first
+// exception is rethrown after all the workers are joined
+template<typename Work>
+void run_workers(unsigned int num_threads, std::uint64_t num_items, const Work &work) {
+   unsigned int num_workers = worker_count(num_threads, num_items);
+   std::atomic<std::uint64_t> next_item{0};
+   std::mutex failure_mutex;
+   std::exception_ptr failure;
+   auto run_worker = [&](unsigned int worker_idx) {
+      try {
+         for (std::uint64_t item_idx = next_item++; item_idx < num_items; item_idx = next_item++) {
+            work(worker_idx, item_idx);
+         }
+      } catch (...) {
+         std::lock_guard<std::mutex> lock(failure_mutex);
+         if (not failure) {
+            failure = std::current_exception();
+         }
+         next_item = num_items;
+      }
+   };
+
+   std::vector<std::thread> workers;
+   for (unsigned int worker_idx = 1; worker_idx < num_workers; ++worker_idx) {
+      workers.emplace_back(run_worker, worker_idx);
+   }
+   run_worker(0);
+   for (auto &worker : workers) {
+      worker.join();
+   }
+   if (failure) {
+      std::rethrow_exception(failure);
+   }
+}
+
+#endif //SUDOKU_PARALLELWORK_H
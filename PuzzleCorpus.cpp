@@ -0,0 +1,373 @@
+//
+// Implementation file for the packed binary corpus
+//
+
+#include "PuzzleCorpus.h"
+#include "SudokuSolver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const char PuzzleCorpus::MAGIC[4] = {'S', 'D', 'K', 'C'};
+const unsigned int PuzzleCorpus::VERSION = 1;
+const std::size_t PuzzleCorpus::HEADER_BYTES = 16;
+const unsigned int MAX_ONE_LINE_SIZE = 35;
+
+namespace {
+   const unsigned char HAS_SOLUTIONS_FLAG = 1;
+
+   void write_header(std::ofstream &file, unsigned int size, bool with_solutions, std::uint64_t count) {
+      unsigned char header[16] = {};
+      std::memcpy(header, PuzzleCorpus::MAGIC, 4);
+      header[4] = static_cast<unsigned char>(PuzzleCorpus::VERSION);
+      header[5] = static_cast<unsigned char>(size);
+      header[6] = static_cast<unsigned char>(PuzzleCorpus::bits_per_tile(size));
+      header[7] = with_solutions ? HAS_SOLUTIONS_FLAG : 0;
+      for (unsigned int byte = 0; byte != 8; ++byte) {
+         header[8 + byte] = static_cast<unsigned char>(count >> (8 * byte));
+      }
+      file.write(reinterpret_cast<const char *>(header), sizeof(header));
+   }
+
+   // The end of the field starting at @p begin: the field ends at the first comma, space or tab, and a trailing
+   // carriage return is not part of it
+   const char *one_line_field_end(const char *begin, const char *end) {
+      const char *field_end = std::find_if(begin, end, [](char symbol) {
+         return symbol == ',' or symbol == ' ' or symbol == '\t';
+      });
+      while (field_end != begin and field_end[-1] == '\r') {
+         --field_end;
+      }
+      return field_end;
+   }
+
+   template<typename Grid>
+   bool solve_grid(const Grid &grid, std::vector<unsigned int> &solution) {
+      try {
+         SudokuSolver sudoku(grid);
+         if (sudoku.solve() and sudoku.has_legal_solution()) {
+            extract_tiles(sudoku, solution);
+            return true;
+         }
+      } catch (std::invalid_argument &) {
+         // a grid whose size is not a square has no solution
+      }
+      return false;
+   }
+}
+
+////////////////////////////////////////               MappedFile               ////////////////////////////////////////
+
+MappedFile::MappedFile(const std::string &path) : _data{nullptr}, _size{0} {
+   int fd = ::open(path.c_str(), O_RDONLY);
+   if (fd < 0) {
+      throw std::invalid_argument("Cannot open the file \"" + path + "\"");
+   }
+   struct stat file_stat{};
+   if (::fstat(fd, &file_stat) != 0) {
+      ::close(fd);
+      throw std::invalid_argument("Cannot read the size of the file \"" + path + "\"");
+   }
+   _size = static_cast<std::size_t>(file_stat.st_size);
+   if (_size != 0) {
+      void *mapping = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapping == MAP_FAILED) {
+         ::close(fd);
+         throw std::invalid_argument("Cannot map the file \"" + path + "\"");
+      }
+      ::madvise(mapping, _size, MADV_SEQUENTIAL);
+      _data = static_cast<const unsigned char *>(mapping);
+   }
+   ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+   if (_data) {
+      ::munmap(const_cast<unsigned char *>(_data), _size);
+   }
+}
+
+////////////////////////////////////////              PuzzleCorpus              ////////////////////////////////////////
+
+PuzzleCorpus::PuzzleCorpus(const std::string &path) : _file{path} {
+   const unsigned char *header = _file.data();
+   if (_file.size() < HEADER_BYTES or std::memcmp(header, MAGIC, 4) != 0 or header[4] != VERSION or
+       header[5] == 0 or header[5] >= 64 or header[6] != bits_per_tile(header[5])) {
+      throw std::invalid_argument("The file \"" + path + "\" is not a puzzle corpus");
+   }
+   _size = header[5];
+   auto region_size = static_cast<unsigned int>(std::sqrt(_size));
+   if (region_size * region_size != _size) {
+      throw std::invalid_argument("The corpus file \"" + path + "\" has grids of size " + std::to_string(_size) +
+                                  ", which is not a perfect square");
+   }
+   _bits_per_tile = header[6];
+   _has_solutions = (header[7] & HAS_SOLUTIONS_FLAG) != 0;
+   _count = 0;
+   for (unsigned int byte = 0; byte != 8; ++byte) {
+      _count |= static_cast<std::uint64_t>(header[8 + byte]) << (8 * byte);
+   }
+   _grid_bytes = grid_bytes(_size);
+   if ((_file.size() - HEADER_BYTES) / stride() < _count) {
+      throw std::invalid_argument("The corpus file \"" + path + "\" is truncated");
+   }
+}
+
+bool PuzzleCorpus::is_corpus_file(const std::string &path) {
+   std::ifstream file(path, std::ios::binary);
+   if (not file.is_open()) {
+      throw std::invalid_argument("Cannot open the file \"" + path + "\"");
+   }
+   char magic[sizeof(MAGIC)] = {};
+   file.read(magic, sizeof(magic));
+   return file.gcount() == sizeof(magic) and std::memcmp(magic, MAGIC, sizeof(magic)) == 0;
+}
+
+unsigned int PuzzleCorpus::bits_per_tile(unsigned int size) {
+   if (size == 0 or size >= 64) {
+      throw std::invalid_argument("Grids of size " + std::to_string(size) + " cannot be stored in a corpus");
+   }
+   return size < 16 ? 4 : (size < 32 ? 5 : 6);
+}
+
+void PuzzleCorpus::pack(const unsigned int *tiles, unsigned int size, unsigned char *output) {
+   unsigned int bits = bits_per_tile(size);
+   std::memset(output, 0, grid_bytes(size));
+   for (std::size_t idx = 0; idx != static_cast<std::size_t>(size) * size; ++idx) {
+      if (tiles[idx] > size) {
+         throw std::invalid_argument("Cannot pack the value " + std::to_string(tiles[idx]) + " in a grid of size " +
+                                     std::to_string(size));
+      }
+      std::size_t bit_pos = idx * bits;
+      unsigned int shifted = tiles[idx] << (bit_pos % 8);
+      output[bit_pos / 8] |= static_cast<unsigned char>(shifted);
+      if (bit_pos % 8 + bits > 8) {
+         output[bit_pos / 8 + 1] |= static_cast<unsigned char>(shifted >> 8u);
+      }
+   }
+}
+
+////////////////////////////////////////           PuzzleCorpusWriter           ////////////////////////////////////////
+
+PuzzleCorpusWriter::PuzzleCorpusWriter(const std::string &path, unsigned int size_, bool with_solutions_) :
+      _file{path, std::ios::binary | std::ios::trunc}, _count{0}, _size{size_}, _has_solutions{with_solutions_} {
+   if (not _file.is_open()) {
+      throw std::invalid_argument("Cannot create the corpus file \"" + path + "\"");
+   }
+   std::size_t grid_bytes = PuzzleCorpus::grid_bytes(_size);
+   _buffer.assign(_has_solutions ? 2 * grid_bytes : grid_bytes, 0);
+   write_header(_file, _size, _has_solutions, 0);
+}
+
+PuzzleCorpusWriter::~PuzzleCorpusWriter() {
+   if (_file.is_open()) {
+      close();
+   }
+}
+
+void PuzzleCorpusWriter::append(const unsigned int *puzzle, const unsigned int *solution) {
+   std::size_t grid_bytes = PuzzleCorpus::grid_bytes(_size);
+   PuzzleCorpus::pack(puzzle, _size, _buffer.data());
+   if (_has_solutions) {
+      if (solution) {
+         PuzzleCorpus::pack(solution, _size, _buffer.data() + grid_bytes);
+      } else {
+         std::memset(_buffer.data() + grid_bytes, 0, grid_bytes);
+      }
+   }
+   _file.write(reinterpret_cast<const char *>(_buffer.data()), static_cast<std::streamsize>(_buffer.size()));
+   ++_count;
+}
+
+void PuzzleCorpusWriter::close() {
+   _file.seekp(0);
+   write_header(_file, _size, _has_solutions, _count);
+   _file.close();
+}
+
+////////////////////////////////////////          non-member functions          ////////////////////////////////////////
+
+void check_one_line_size(unsigned int size) {
+   if (size > MAX_ONE_LINE_SIZE) {
+      throw std::invalid_argument("Grids of size " + std::to_string(size) +
+                                  " cannot be written in the one-line format");
+   }
+}
+
+bool is_blank_line(const char *begin, const char *end) {
+   return std::all_of(begin, end, [](char symbol) { return symbol == ' ' or symbol == '\t' or symbol == '\r'; });
+}
+
+unsigned int read_one_line_field(const char *&begin, const char *end, std::vector<unsigned int> &tiles) {
+   begin = std::find_if(begin, end, [](char symbol) { return symbol != ' ' and symbol != '\t'; });
+   const char *field_end = one_line_field_end(begin, end);
+   unsigned int size = 0;
+   try {
+      size = parse_one_line(begin, field_end, tiles);
+   } catch (std::invalid_argument &) {
+      // a grid too large for the one-line format
+   }
+   begin = std::find_if(field_end, end, [](char symbol) {
+      return symbol != ',' and symbol != ' ' and symbol != '\t' and symbol != '\r';
+   });
+   return size;
+}
+
+unsigned int parse_one_line(const char *begin, const char *end, std::vector<unsigned int> &tiles) {
+   while (end != begin and (end[-1] == '\r' or end[-1] == '\n' or end[-1] == ' ')) {
+      --end;
+   }
+   auto num_tiles = static_cast<unsigned int>(end - begin);
+   unsigned int size = 1;
+   while (size * size < num_tiles) {
+      ++size;
+   }
+   if (num_tiles == 0 or size * size != num_tiles) {
+      return 0;
+   }
+   check_one_line_size(size);
+   tiles.resize(num_tiles);
+   for (unsigned int idx = 0; idx != num_tiles; ++idx) {
+      char symbol = begin[idx];
+      if (symbol == '.' or symbol == '0') {
+         tiles[idx] = 0;
+      } else if (symbol >= '1' and symbol <= '9') {
+         tiles[idx] = static_cast<unsigned int>(symbol - '0');
+      } else if (symbol >= 'A' and symbol <= 'Z') {
+         tiles[idx] = static_cast<unsigned int>(symbol - 'A') + 10;
+      } else if (symbol >= 'a' and symbol <= 'z') {
+         tiles[idx] = static_cast<unsigned int>(symbol - 'a') + 10;
+      } else {
+         return 0;
+      }
+      if (tiles[idx] > size) {
+         return 0;
+      }
+   }
+   return size;
+}
+
+void format_one_line(const unsigned int *tiles, unsigned int size, std::string &output) {
+   check_one_line_size(size);
+   for (std::size_t idx = 0; idx != static_cast<std::size_t>(size) * size; ++idx) {
+      if (tiles[idx] == 0) {
+         output.push_back('.');
+      } else if (tiles[idx] <= 9) {
+         output.push_back(static_cast<char>('0' + tiles[idx]));
+      } else {
+         output.push_back(static_cast<char>('A' + tiles[idx] - 10));
+      }
+   }
+}
+
+void format_solution_line(const unsigned int *tiles, const unsigned int *solution, unsigned int size,
+                          std::string &output) {
+   format_one_line(tiles, size, output);
+   output.push_back(',');
+   if (solution) {
+      format_one_line(solution, size, output);
+   }
+   output.push_back('\n');
+}
+
+void format_unreadable_line(const char *begin, const char *end, std::string &output) {
+   output.append(begin, end != begin and end[-1] == '\r' ? end - 1 : end);
+   output += ",\n";
+}
+
+bool solve_puzzle(const PuzzleRecord &record, std::vector<unsigned int> &solution) {
+   return solve_grid(record, solution);
+}
+
+bool solve_puzzle(const std::vector<unsigned int> &tiles, std::vector<unsigned int> &solution) {
+   return solve_grid(tiles, solution);
+}
+
+std::uint64_t convert_to_corpus(std::istream &input, PuzzleTextFormat format, unsigned int size,
+                                const std::string &output_path, bool with_solutions) {
+   std::vector<unsigned int> puzzle, solution;
+   std::string line;
+
+   // reads the next puzzle in puzzle, and returns false at the end of the input
+   auto read_puzzle = [&]() -> bool {
+      if (format == PuzzleTextFormat::ONE_LINE) {
+         while (std::getline(input, line)) {
+            if (is_blank_line(line.data(), line.data() + line.size())) {
+               continue;
+            }
+            // only the first field is the puzzle, the rest of the line (for example a solution) is ignored
+            const char *field = line.data();
+            unsigned int line_size = read_one_line_field(field, line.data() + line.size(), puzzle);
+            if (line_size == 0 or (size != 0 and line_size != size)) {
+               throw std::invalid_argument("The line \"" + line + "\" is not a puzzle of the corpus");
+            }
+            size = line_size;
+            return true;
+         }
+         return false;
+      }
+      if (size == 0) {
+         while (std::getline(input, line) and line.find_first_not_of(" \t\r") == std::string::npos) {}
+         std::istringstream first_line{line};
+         unsigned int n = 0;
+         while (first_line >> n) {
+            puzzle.push_back(n);
+            ++size;
+         }
+         if (size == 0) {
+            return false;
+         }
+      }
+      while (puzzle.size() < static_cast<std::size_t>(size) * size) {
+         unsigned int n = 0;
+         if (not(input >> n)) {
+            if (not puzzle.empty()) {
+               throw std::invalid_argument("The input ends with an incomplete puzzle");
+            }
+            return false;
+         }
+         puzzle.push_back(n);
+      }
+      return true;
+   };
+
+   std::unique_ptr<PuzzleCorpusWriter> writer;
+   while (read_puzzle()) {
+      if (not writer) {
+         auto region_size = static_cast<unsigned int>(std::sqrt(size));
+         if (region_size * region_size != size) {
+            throw std::invalid_argument("The size of a sudoku must be a perfect square, not " + std::to_string(size));
+         }
+         writer = std::make_unique<PuzzleCorpusWriter>(output_path, size, with_solutions);
+      }
+      bool is_solved = with_solutions and solve_puzzle(puzzle, solution);
+      writer->append(puzzle.data(), is_solved ? solution.data() : nullptr);
+      if (format == PuzzleTextFormat::GRID) {
+         puzzle.clear();
+      }
+   }
+   if (not writer) {
+      throw std::invalid_argument("The input does not contain any puzzle. See the README file");
+   }
+   writer->close();
+   return writer->count();
+}
+
+void extract_tiles(const SudokuSolver &sudoku, std::vector<unsigned int> &tiles) {
+   tiles.resize(static_cast<std::size_t>(sudoku.get_size()) * sudoku.get_size());
+   auto tile_it = tiles.begin();
+   SudokuSolver::Coord coord;
+   for (coord.row_idx = 0; coord.row_idx != sudoku.get_size(); ++coord.row_idx) {
+      for (coord.col_idx = 0; coord.col_idx != sudoku.get_size(); ++coord.col_idx) {
+         *tile_it++ = static_cast<unsigned int>(sudoku.get_tile(coord).value());
+      }
+   }
+}
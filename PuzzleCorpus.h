@@ -0,0 +1,226 @@
+//
+// Packed binary corpus of Sudoku puzzles
+//
+// A corpus file is a 16 bytes header followed by fixed-stride records:
+//
+//    offset  size  field
+//    0       4     magic "SDKC"
+//    4       1     format version (currently 1)
+//    5       1     grid size (9, 16, 25, ...)
+//    6       1     bits per tile (4 for size < 16, 5 for size < 32, 6 for size < 64)
+//    7       1     flags (bit 0: every record is followed by a solution slot)
+//    8       8     number of records (little endian)
+//
+// Each record packs the size * size tiles, row by row, into bits_per_tile bits each (least significant bit first),
+// padded to a whole number of bytes. An empty tile is 0. When the solution slot is present it has the same layout
+// and follows the puzzle, so the stride is twice the packed grid; an unsolved slot is all zeros.
+//
+
+#ifndef SUDOKU_PUZZLECORPUS_H
+#define SUDOKU_PUZZLECORPUS_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class SudokuSolver;
+
+// A read-only memory mapping of a whole file
+class MappedFile {
+public:
+   // maps the file @p path. Throws std::invalid_argument if it cannot be mapped
+   explicit MappedFile(const std::string &path);
+
+   MappedFile(const MappedFile &) = delete;
+
+   MappedFile &operator=(const MappedFile &) = delete;
+
+   ~MappedFile();
+
+   const unsigned char *data() const { return _data; }
+
+   std::size_t size() const { return _size; }
+
+private:
+   const unsigned char *_data;  // the first byte of the file, null if the file is empty
+   std::size_t _size;  // the length of the file
+};
+
+// A read-only view of a single packed grid. It does not own the memory it points to
+class PuzzleRecord {
+public:
+   PuzzleRecord(const unsigned char *data_, unsigned int size_, unsigned int bits_per_tile_) :
+         _data{data_}, _size{size_}, _bits_per_tile{bits_per_tile_} {}
+
+   // The value of the tile of index @p idx (row-major), 0 if the tile is empty
+   unsigned int tile(unsigned int idx) const {
+      std::size_t bit_pos = static_cast<std::size_t>(idx) * _bits_per_tile;
+      unsigned int bits = _data[bit_pos / 8];
+      if (bit_pos % 8 + _bits_per_tile > 8) {
+         bits |= static_cast<unsigned int>(_data[bit_pos / 8 + 1]) << 8u;
+      }
+      return (bits >> (bit_pos % 8)) & ((1u << _bits_per_tile) - 1);
+   }
+
+   // decodes all the tiles, row by row, into @p tiles, which must have room for num_tiles() values
+   void unpack(unsigned int *tiles) const {
+      for (unsigned int idx = 0; idx != num_tiles(); ++idx) {
+         tiles[idx] = tile(idx);
+      }
+   }
+
+   unsigned int get_size() const { return _size; }
+
+   unsigned int num_tiles() const { return _size * _size; }
+
+private:
+   const unsigned char *_data;  // the first byte of the packed grid
+   unsigned int _size;  // the length of the grid (usually 9)
+   unsigned int _bits_per_tile;  // the number of bits used by each tile
+};
+
+// A memory-mapped corpus file. Records are decoded on demand, so opening even a huge corpus is immediate
+class PuzzleCorpus {
+public:
+   // maps the corpus in file @p path. Throws std::invalid_argument if the file is not a valid corpus
+   explicit PuzzleCorpus(const std::string &path);
+
+   // Tells if the file @p path starts like a corpus (otherwise it is read as text).
+   // Throws std::invalid_argument if it cannot be opened
+   static bool is_corpus_file(const std::string &path);
+
+   // the puzzle of the record of index @p idx
+   PuzzleRecord puzzle(std::uint64_t idx) const {
+      return PuzzleRecord{record_data(idx), _size, _bits_per_tile};
+   }
+
+   // the solution slot of the record of index @p idx. Only meaningful if has_solutions()
+   PuzzleRecord solution(std::uint64_t idx) const {
+      return PuzzleRecord{record_data(idx) + _grid_bytes, _size, _bits_per_tile};
+   }
+
+   std::uint64_t count() const { return _count; }
+
+   unsigned int get_size() const { return _size; }
+
+   bool has_solutions() const { return _has_solutions; }
+
+   // the number of bytes between two consecutive records
+   std::size_t stride() const { return _has_solutions ? 2 * _grid_bytes : _grid_bytes; }
+
+   static const char MAGIC[4];
+   static const unsigned int VERSION;
+   static const std::size_t HEADER_BYTES;
+
+   // the number of bits needed by each tile of a grid of size @p size. Throws if the size cannot be packed
+   static unsigned int bits_per_tile(unsigned int size);
+
+   // the number of bytes of a packed grid of size @p size
+   static std::size_t grid_bytes(unsigned int size) {
+      return (static_cast<std::size_t>(size) * size * bits_per_tile(size) + 7) / 8;
+   }
+
+   // packs the @p size * @p size values in @p tiles into @p output, which must hold grid_bytes(size) bytes
+   static void pack(const unsigned int *tiles, unsigned int size, unsigned char *output);
+
+private:
+   const unsigned char *record_data(std::uint64_t idx) const {
+      return _file.data() + HEADER_BYTES + idx * stride();
+   }
+
+   MappedFile _file;
+   std::uint64_t _count;  // the number of records
+   unsigned int _size;  // the length of the grids (usually 9)
+   unsigned int _bits_per_tile;  // the number of bits used by each tile
+   std::size_t _grid_bytes;  // the number of bytes of a packed grid
+   bool _has_solutions;  // tells if each record has a solution slot
+};
+
+// Writes a corpus file record by record. The header is completed when the writer is closed
+class PuzzleCorpusWriter {
+public:
+   PuzzleCorpusWriter(const std::string &path, unsigned int size_, bool with_solutions_);
+
+   PuzzleCorpusWriter(const PuzzleCorpusWriter &) = delete;
+
+   PuzzleCorpusWriter &operator=(const PuzzleCorpusWriter &) = delete;
+
+   ~PuzzleCorpusWriter();
+
+   // appends a record with the puzzle @p puzzle and (if the corpus has solutions) the solution @p solution.
+   // Both are size * size values in row-major order; a null @p solution leaves the solution slot empty
+   void append(const unsigned int *puzzle, const unsigned int *solution = nullptr);
+
+   // writes the number of records in the header and closes the file
+   void close();
+
+   std::uint64_t count() const { return _count; }
+
+   unsigned int get_size() const { return _size; }
+
+   bool has_solutions() const { return _has_solutions; }
+
+private:
+   std::ofstream _file;
+   std::vector<unsigned char> _buffer;  // the packed record being written
+   std::uint64_t _count;  // the number of records written so far
+   unsigned int _size;  // the length of the grids
+   bool _has_solutions;  // tells if each record has a solution slot
+};
+
+// The text formats accepted by the converter
+enum class PuzzleTextFormat {
+   GRID,  // the format described in the README: whitespace separated numbers, size * size of them per puzzle
+   ONE_LINE  // one puzzle per line, one character per tile: '0' or '.' if empty, then '1'-'9' and 'A'-'Z'
+};
+
+// The largest size of the grids in the one-line format, whose symbols stop at 'Z' for 35
+extern const unsigned int MAX_ONE_LINE_SIZE;
+
+// Throws std::invalid_argument if grids of size @p size cannot be written in the one-line format
+void check_one_line_size(unsigned int size);
+
+// Tells if the line [@p begin, @p end) only holds spaces, tabs and carriage returns
+bool is_blank_line(const char *begin, const char *end);
+
+// Reads the grid of the field at @p begin of the line ending at @p end, in the one-line format, into @p tiles.
+// Fields are separated by commas, spaces or tabs: the first one is the puzzle, the second one (if any) its solution.
+// Spaces and tabs before the field are skipped, and @p begin is moved to the next field.
+// Returns the size of the grid, or 0 if the field is not a grid that can be written in the one-line format
+unsigned int read_one_line_field(const char *&begin, const char *end, std::vector<unsigned int> &tiles);
+
+// Parses a puzzle in the one-line format from [@p begin, @p end) into @p tiles.
+// Returns the size of the grid, or 0 if the text is not a puzzle. Throws if the grid is larger than MAX_ONE_LINE_SIZE
+unsigned int parse_one_line(const char *begin, const char *end, std::vector<unsigned int> &tiles);
+
+// Writes the @p size * @p size values of @p tiles in the one-line format at the end of @p output.
+// Throws if @p size is larger than MAX_ONE_LINE_SIZE
+void format_one_line(const unsigned int *tiles, unsigned int size, std::string &output);
+
+// Writes the line "puzzle,solution" of the puzzle @p tiles of size @p size at the end of @p output, or "puzzle," if
+// @p solution is null
+void format_solution_line(const unsigned int *tiles, const unsigned int *solution, unsigned int size,
+                          std::string &output);
+
+// Writes the line of the solutions of the text line [@p begin, @p end), which is not a puzzle, at the end of @p output:
+// the text (without a trailing carriage return) followed by a comma, so that the output keeps a line per input line
+void format_unreadable_line(const char *begin, const char *end, std::string &output);
+
+// Solves the puzzle @p record (or @p tiles, its values row by row) and copies its solution to @p solution.
+// Returns false if the puzzle has no solution, or if it is not a sudoku grid (its size is not a square)
+bool solve_puzzle(const PuzzleRecord &record, std::vector<unsigned int> &solution);
+
+bool solve_puzzle(const std::vector<unsigned int> &tiles, std::vector<unsigned int> &solution);
+
+// Converts the puzzles in the text @p input into the corpus file @p output_path.
+// For the GRID format, @p size is the size of the grids (0 to deduce it from the first line).
+// If @p with_solutions, every puzzle is solved and its solution is stored in the record.
+// Returns the number of converted puzzles
+std::uint64_t convert_to_corpus(std::istream &input, PuzzleTextFormat format, unsigned int size,
+                                const std::string &output_path, bool with_solutions);
+
+// Copies the current values of the tiles of @p sudoku into @p tiles, row by row
+void extract_tiles(const SudokuSolver &sudoku, std::vector<unsigned int> &tiles);
+
+#endif //SUDOKU_PUZZLECORPUS_H
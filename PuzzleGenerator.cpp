@@ -0,0 +1,111 @@
+//
+// Implementation file for the generation of Sudoku puzzles
+//
+
+#include "PuzzleGenerator.h"
+#include "ParallelWork.h"
+#include "PuzzleCorpus.h"
+#include "SudokuSolver.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+
+const std::uint64_t PuzzleGenerator::FIRST_GUESSES_PER_CHECK = 1000;
+const std::uint64_t PuzzleGenerator::DEFAULT_MAX_GUESSES_PER_CHECK = 1000;
+
+PuzzleGenerator::PuzzleGenerator(unsigned int size_, std::uint64_t seed, std::uint64_t max_guesses_per_check) :
+      _random_engine{seed}, _removal_order(size_ * size_), _max_guesses_per_check{max_guesses_per_check},
+      _size{size_} {
+   auto region_size = static_cast<unsigned int>(std::sqrt(_size));
+   if (region_size * region_size != _size) {
+      throw std::invalid_argument("The size of a sudoku must be a perfect square, not " + std::to_string(_size));
+   }
+}
+
+unsigned int PuzzleGenerator::generate(unsigned int target_clues, std::vector<unsigned int> &puzzle,
+                               std::vector<unsigned int> &solution) {
+   puzzle.assign(_removal_order.size(), 0);
+   SudokuSolver sudoku(puzzle);
+   sudoku.randomize_guesses(static_cast<unsigned int>(_random_engine()));
+   if (not sudoku.solve() or not sudoku.has_legal_solution()) {
+      throw std::logic_error("Could not fill the empty grid of size " + std::to_string(_size));
+   }
+   extract_tiles(sudoku, solution);
+
+   puzzle = solution;
+   auto num_clues = static_cast<unsigned int>(puzzle.size());
+   _removal_order.resize(puzzle.size());
+   std::iota(_removal_order.begin(), _removal_order.end(), 0);
+   std::shuffle(_removal_order.begin(), _removal_order.end(), _random_engine);
+   std::uint64_t max_guesses = _max_guesses_per_check == 0 ? 0 : std::min(FIRST_GUESSES_PER_CHECK,
+                                                                          _max_guesses_per_check);
+   while (true) {
+      _undecided.clear();
+      for (unsigned int tile_idx : _removal_order) {
+         if (num_clues <= target_clues) {
+            return 0;
+         }
+         puzzle[tile_idx] = 0;
+         Uniqueness uniqueness = check_uniqueness(puzzle, max_guesses);
+         if (uniqueness == Uniqueness::UNIQUE) {
+            --num_clues;
+         } else {
+            if (uniqueness == Uniqueness::UNKNOWN) {
+               _undecided.push_back(tile_idx);
+            }
+            puzzle[tile_idx] = solution[tile_idx];
+         }
+      }
+      if (_undecided.empty() or max_guesses == _max_guesses_per_check) {
+         break;
+      }
+      max_guesses = std::min(max_guesses * 10, _max_guesses_per_check);
+      _removal_order.swap(_undecided);
+   }
+   return static_cast<unsigned int>(_undecided.size());
+}
+
+PuzzleGenerator::Uniqueness PuzzleGenerator::check_uniqueness(const std::vector<unsigned int> &puzzle,
+                                                              std::uint64_t max_guesses) {
+   SudokuSolver sudoku(puzzle);
+   unsigned int num_solutions = sudoku.count_solutions(2, max_guesses);
+   if (num_solutions > 1) {
+      return Uniqueness::MULTIPLE;
+   }
+   return sudoku.get_is_out_of_guesses() ? Uniqueness::UNKNOWN : Uniqueness::UNIQUE;
+}
+
+////////////////////////////////////////          non-member functions          ////////////////////////////////////////
+
+GenerationReport generate_puzzles(unsigned int size, unsigned int target_clues, std::uint64_t max_guesses_per_check,
+                                  std::uint64_t num_puzzles, unsigned int num_threads, std::uint64_t seed,
+                                  const std::function<void(std::uint64_t idx, const std::vector<unsigned int> &puzzle,
+                                                           const std::vector<unsigned int> &solution)> &consume) {
+   auto start = std::chrono::steady_clock::now();
+   GenerationReport report;
+   std::mutex consume_mutex;
+   run_workers(num_threads, num_puzzles, [&](unsigned int, std::uint64_t idx) {
+      // every puzzle has its own seed, so the output does not depend on the scheduling of the threads
+      PuzzleGenerator generator(size, seed + idx * 0x9E3779B97F4A7C15ull, max_guesses_per_check);
+      std::vector<unsigned int> puzzle, solution;
+      unsigned int num_undecided = generator.generate(target_clues, puzzle, solution);
+      auto num_clues = static_cast<std::uint64_t>(
+            std::count_if(puzzle.begin(), puzzle.end(), [](unsigned int value) { return value != 0; }));
+      std::lock_guard<std::mutex> lock(consume_mutex);
+      consume(idx, puzzle, solution);
+      ++report.num_puzzles;
+      report.num_clues += num_clues;
+      if (target_clues != 0 and num_clues > target_clues) {
+         ++report.num_missed_targets;
+      }
+      if (num_undecided != 0) {
+         ++report.num_out_of_guesses;
+      }
+   });
+   report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   return report;
+}
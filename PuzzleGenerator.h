@@ -0,0 +1,76 @@
+//
+// Generation of Sudoku puzzles with a unique solution
+//
+
+#ifndef SUDOKU_PUZZLEGENERATOR_H
+#define SUDOKU_PUZZLEGENERATOR_H
+
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <vector>
+
+// Generates puzzles of a fixed size: a random full grid is built by solving the empty grid with randomized guesses,
+// then clues are removed in random order as long as the puzzle keeps a unique solution.
+// Every check of uniqueness has a budget of guesses, so large grids are generated in bounded time. The clues whose
+// removal could not be proved safe within the budget are tried again, once all the others have been tried, with a
+// budget ten times larger, until the target is met or the budget reaches its maximum. Minimal puzzles of a random full
+// grid keep about 31% of the tiles as clues for 9x9 grids and 36% for 16x16 grids, so lower targets are usually missed.
+// A generator is not thread safe, each thread should use its own instance
+class PuzzleGenerator {
+public:
+   // @p max_guesses_per_check is the largest budget of guesses of a check of uniqueness (0 means no bound)
+   PuzzleGenerator(unsigned int size_, std::uint64_t seed,
+                   std::uint64_t max_guesses_per_check = DEFAULT_MAX_GUESSES_PER_CHECK);
+
+   // Generates a puzzle in @p puzzle and its solution in @p solution (size * size values each, row by row).
+   // Clues are removed until only @p target_clues are left, or until no clue can be removed without losing uniqueness.
+   // Returns the number of clues kept only because the largest budget was not enough to prove their removal safe
+   // (0 if the target is met)
+   unsigned int generate(unsigned int target_clues, std::vector<unsigned int> &puzzle,
+                         std::vector<unsigned int> &solution);
+
+   static const std::uint64_t FIRST_GUESSES_PER_CHECK;  // the budget of guesses of the first check of each clue
+   static const std::uint64_t DEFAULT_MAX_GUESSES_PER_CHECK;
+
+   unsigned int get_size() const { return _size; }
+
+private:
+   enum class Uniqueness {
+      UNIQUE, MULTIPLE, UNKNOWN
+   };
+
+   // Tells if @p puzzle has exactly one solution, or UNKNOWN if this is not settled within @p max_guesses guesses
+   static Uniqueness check_uniqueness(const std::vector<unsigned int> &puzzle, std::uint64_t max_guesses);
+
+   std::mt19937_64 _random_engine;
+   std::vector<unsigned int> _removal_order;  // the order in which the tiles are tried for removal
+   std::vector<unsigned int> _undecided;  // the tiles whose check ran out of guesses, to try again with a larger budget
+   std::uint64_t _max_guesses_per_check;  // the largest budget of guesses of a check of uniqueness (0 means no bound)
+   unsigned int _size;  // the length of the grid (usually 9)
+};
+
+// The outcome of a generation run
+struct GenerationReport {
+   std::uint64_t num_puzzles = 0;
+   std::uint64_t num_clues = 0;  // the total number of clues in the generated puzzles
+   std::uint64_t num_missed_targets = 0;  // the puzzles left with more clues than the target (if any)
+   std::uint64_t num_out_of_guesses = 0;  // the puzzles keeping clues whose removal could not be proved safe in budget
+   double seconds = 0;  // the wall-clock time of the generation
+
+   double puzzles_per_second() const { return seconds > 0 ? static_cast<double>(num_puzzles) / seconds : 0; }
+
+   double average_clues() const { return num_puzzles ? static_cast<double>(num_clues) / num_puzzles : 0; }
+};
+
+// Generates @p num_puzzles puzzles of size @p size with (at most, when possible) @p target_clues clues, running
+// @p num_threads independent generators (0 means one per core), whose checks of uniqueness make up to
+// @p max_guesses_per_check guesses. Puzzle idx is always generated from the same random
+// sequence, derived from @p seed and idx. Every puzzle is passed to @p consume as soon as it is ready, with calls
+// serialized across threads but not sorted by idx
+GenerationReport generate_puzzles(unsigned int size, unsigned int target_clues, std::uint64_t max_guesses_per_check,
+                                  std::uint64_t num_puzzles, unsigned int num_threads, std::uint64_t seed,
+                                  const std::function<void(std::uint64_t idx, const std::vector<unsigned int> &puzzle,
+                                                           const std::vector<unsigned int> &solution)> &consume);
+
+#endif //SUDOKU_PUZZLEGENERATOR_H
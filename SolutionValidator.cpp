@@ -0,0 +1,176 @@
+//
+// Implementation file for the bulk validation of completed Sudoku grids
+//
+
+#include "SolutionValidator.h"
+#include "ParallelWork.h"
+#include "PuzzleCorpus.h"
+#include "SudokuTopology.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+   // loads the grid of index idx in puzzle and solution. Returns false if the grid cannot be read
+   typedef std::function<bool(std::uint64_t idx, std::vector<unsigned int> &puzzle,
+                              std::vector<unsigned int> &solution)> GridLoader;
+
+   // The scratch memory and the findings of a worker of validate_in_parallel
+   struct ValidationWorker {
+      SolutionValidator validator;
+      std::vector<unsigned int> puzzle, solution;
+      std::vector<ValidationError> errors;
+      std::vector<ValidationReport::InvalidGrid> invalid_grids;  // sorted by idx
+
+      explicit ValidationWorker(const SolutionValidator &validator_) : validator{validator_} {}
+   };
+
+   // Validates the grids of index in [0, num_grids) of size @p size on @p num_threads threads
+   ValidationReport validate_in_parallel(std::uint64_t num_grids, unsigned int size, unsigned int num_threads,
+                                         const GridLoader &load) {
+      auto start = std::chrono::steady_clock::now();
+      // built before the threads start, so that an illegal size is reported here; each worker uses a copy
+      const SolutionValidator prototype(size);
+      std::vector<ValidationWorker> workers(worker_count(num_threads, num_grids), ValidationWorker{prototype});
+      run_workers(num_threads, num_grids, [&](unsigned int worker_idx, std::uint64_t idx) {
+         ValidationWorker &worker = workers[worker_idx];
+         worker.errors.clear();
+         if (not load(idx, worker.puzzle, worker.solution)) {
+            worker.errors.emplace_back(ValidationError::MALFORMED, 0, 0);
+         } else if (worker.validator.validate(worker.puzzle.data(), worker.solution.data(), &worker.errors)) {
+            return;
+         }
+         worker.invalid_grids.push_back(ValidationReport::InvalidGrid{idx, worker.errors});
+      });
+
+      ValidationReport report;
+      report.num_grids = num_grids;
+      for (auto &worker : workers) {
+         std::move(worker.invalid_grids.begin(), worker.invalid_grids.end(), std::back_inserter(report.invalid_grids));
+      }
+      std::sort(report.invalid_grids.begin(), report.invalid_grids.end(),
+                [](const ValidationReport::InvalidGrid &left, const ValidationReport::InvalidGrid &right) {
+                   return left.idx < right.idx;
+                });
+      report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      return report;
+   }
+}
+
+////////////////////////////////////////            ValidationError             ////////////////////////////////////////
+
+std::string ValidationError::description() const {
+   if (kind == MALFORMED) {
+      return "the grid cannot be read";
+   }
+   static const char *const descriptions[] = {"", "empty tile", "illegal value", "value differs from the puzzle",
+                                              "duplicate value in row", "duplicate value in column",
+                                              "duplicate value in region"};
+   return std::string(descriptions[kind]) + " at row " + std::to_string(row_idx + 1) + ", column " +
+          std::to_string(col_idx + 1);
+}
+
+////////////////////////////////////////           SolutionValidator            ////////////////////////////////////////
+
+SolutionValidator::SolutionValidator(unsigned int size_) : _size{size_} {
+   auto region_size = static_cast<unsigned int>(std::sqrt(_size));
+   if (_size == 0 or region_size * region_size != _size) {
+      throw std::invalid_argument("The size of a sudoku must be a perfect square, not " + std::to_string(_size));
+   }
+   _topology = SudokuTopology::of_size(_size);
+   _seen.assign(static_cast<std::size_t>(3) * _size * _topology->words_per_unit(), 0);
+}
+
+bool SolutionValidator::validate(const unsigned int *puzzle, const unsigned int *solution,
+                                 std::vector<ValidationError> *errors) {
+   std::fill(_seen.begin(), _seen.end(), 0);
+   bool is_legal = true;
+   unsigned int idx = 0;
+   for (unsigned int row_idx = 0; row_idx != _size; ++row_idx) {
+      for (unsigned int col_idx = 0; col_idx != _size; ++col_idx, ++idx) {
+         unsigned int value = solution[idx];
+         ValidationError::Kind kind = ValidationError::MALFORMED;  // never reported for a tile, so it means no error
+         if (value == 0) {
+            kind = ValidationError::MISSING_VALUE;
+         } else if (value > _size) {
+            kind = ValidationError::ILLEGAL_VALUE;
+         } else {
+            if (puzzle[idx] != 0 and puzzle[idx] != value) {
+               is_legal = false;
+               if (not errors) {
+                  return false;
+               }
+               errors->emplace_back(ValidationError::CHANGED_INPUT, row_idx, col_idx);
+            }
+            // a value seen twice in a unit can only be reported once per tile, the row taking precedence
+            unsigned int seen_dir = _topology->mark_seen(_seen.data(), idx, value - 1);
+            if (seen_dir != SudokuTopology::NOT_SEEN) {
+               kind = static_cast<ValidationError::Kind>(ValidationError::DUPLICATE_IN_ROW + seen_dir);
+            }
+         }
+         if (kind != ValidationError::MALFORMED) {
+            is_legal = false;
+            if (not errors) {
+               return false;
+            }
+            errors->emplace_back(kind, row_idx, col_idx);
+         }
+      }
+   }
+   return is_legal;
+}
+
+////////////////////////////////////////          non-member functions          ////////////////////////////////////////
+
+ValidationReport validate_corpus(const PuzzleCorpus &corpus, unsigned int num_threads) {
+   if (not corpus.has_solutions()) {
+      throw std::invalid_argument("The corpus does not contain solutions to validate");
+   }
+   return validate_in_parallel(corpus.count(), corpus.get_size(), num_threads,
+                               [&corpus](std::uint64_t idx, std::vector<unsigned int> &puzzle,
+                                         std::vector<unsigned int> &solution) {
+                                  PuzzleRecord puzzle_record = corpus.puzzle(idx);
+                                  puzzle.resize(puzzle_record.num_tiles());
+                                  solution.resize(puzzle_record.num_tiles());
+                                  puzzle_record.unpack(puzzle.data());
+                                  corpus.solution(idx).unpack(solution.data());
+                                  return true;
+                               });
+}
+
+ValidationReport validate_one_line_text(const std::string &text, unsigned int num_threads) {
+   std::vector<std::pair<std::size_t, std::size_t>> lines;  // the first and one past the last character of each line
+   for (std::size_t line_begin = 0; line_begin < text.size();) {
+      std::size_t line_end = text.find('\n', line_begin);
+      if (line_end == std::string::npos) {
+         line_end = text.size();
+      }
+      if (not is_blank_line(text.data() + line_begin, text.data() + line_end)) {
+         lines.emplace_back(line_begin, line_end);
+      }
+      line_begin = line_end + 1;
+   }
+   if (lines.empty()) {
+      return ValidationReport{};
+   }
+
+   // reads the puzzle and solution of line @p idx, returns their size (0 if the line is malformed)
+   auto parse_line = [&](std::uint64_t idx, std::vector<unsigned int> &puzzle, std::vector<unsigned int> &solution) {
+      const char *field = text.data() + lines[idx].first, *end = text.data() + lines[idx].second;
+      unsigned int size = read_one_line_field(field, end, puzzle);
+      return size != 0 and read_one_line_field(field, end, solution) == size ? size : 0u;
+   };
+
+   std::vector<unsigned int> puzzle, solution;
+   unsigned int size = parse_line(0, puzzle, solution);
+   if (size == 0) {
+      throw std::invalid_argument("The first line of the text is not a puzzle followed by its solution");
+   }
+   return validate_in_parallel(lines.size(), size, num_threads,
+                               [&](std::uint64_t idx, std::vector<unsigned int> &puzzle_,
+                                   std::vector<unsigned int> &solution_) {
+                                  return parse_line(idx, puzzle_, solution_) == size;
+                               });
+}
@@ -0,0 +1,82 @@
+//
+// Bulk validation of completed Sudoku grids
+//
+
+#ifndef SUDOKU_SOLUTIONVALIDATOR_H
+#define SUDOKU_SOLUTIONVALIDATOR_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+class PuzzleCorpus;
+
+class SudokuTopology;
+
+// A problem found in a solution, at the tile with coordinates (row_idx, col_idx)
+struct ValidationError {
+   enum Kind : unsigned int {
+      MALFORMED,  // the grid could not be read (the coordinates are meaningless)
+      MISSING_VALUE,  // the tile is empty
+      ILLEGAL_VALUE,  // the value is not in [1, size]
+      CHANGED_INPUT,  // the value differs from the one given in the puzzle
+      DUPLICATE_IN_ROW,  // the value already appeared before in the same row
+      DUPLICATE_IN_COL,  // the value already appeared before in the same column
+      DUPLICATE_IN_REGION  // the value already appeared before in the same region
+   };
+
+   Kind kind;
+   unsigned int row_idx, col_idx;
+
+   ValidationError(Kind kind_, unsigned int row_idx_, unsigned int col_idx_) :
+         kind{kind_}, row_idx{row_idx_}, col_idx{col_idx_} {}
+
+   // A human readable description of the error
+   std::string description() const;
+};
+
+// Checks completed grids of a fixed size against their puzzles, with a single pass over the tiles.
+// A validator keeps its own scratch memory, so each thread should use its own instance
+class SolutionValidator {
+public:
+   explicit SolutionValidator(unsigned int size_);
+
+   // Validates @p solution against @p puzzle, both given as size * size values in row-major order.
+   // If @p errors is not null, every error found is appended to it, otherwise the check stops at the first error.
+   // Returns true if the solution is a legal completion of the puzzle
+   bool validate(const unsigned int *puzzle, const unsigned int *solution, std::vector<ValidationError> *errors);
+
+   unsigned int get_size() const { return _size; }
+
+private:
+   typedef std::uint64_t Word;
+
+   std::vector<Word> _seen;  // the values already found in each row, column and region, as bitsets
+   std::shared_ptr<const SudokuTopology> _topology;  // the units of the tiles
+   unsigned int _size;  // the length of the grid (usually 9)
+};
+
+// The outcome of the validation of a collection of grids
+struct ValidationReport {
+   struct InvalidGrid {
+      std::uint64_t idx;  // the position of the grid in the collection
+      std::vector<ValidationError> errors;
+   };
+
+   std::uint64_t num_grids = 0;
+   std::vector<InvalidGrid> invalid_grids;  // sorted by idx
+   double seconds = 0;  // the wall-clock time of the validation
+
+   double grids_per_second() const { return seconds > 0 ? static_cast<double>(num_grids) / seconds : 0; }
+};
+
+// Validates the solution slots of all the records of @p corpus, using @p num_threads threads
+ValidationReport validate_corpus(const PuzzleCorpus &corpus, unsigned int num_threads);
+
+// Validates a text in the one-line format where each line holds a puzzle and its solution, separated by a comma or
+// spaces. Empty lines are skipped. Uses @p num_threads threads
+ValidationReport validate_one_line_text(const std::string &text, unsigned int num_threads);
+
+#endif //SUDOKU_SOLUTIONVALIDATOR_H
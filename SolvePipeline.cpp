@@ -0,0 +1,307 @@
+//
+// Implementation file for the pipelined solving of puzzles
+//
+
+#include "SolvePipeline.h"
+#include "BoundedQueue.h"
+#include "PuzzleCorpus.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+   // A puzzle travelling through the pipeline
+   struct PipelinePuzzle {
+      unsigned int size = 0;  // the size of the grid, 0 if the line is not a puzzle
+      bool is_solved = false;
+      std::uint64_t record_idx = 0;  // the record of the puzzle, if it comes from a corpus (it is read in place)
+      std::vector<unsigned int> tiles;  // the values of the puzzle, if it comes from a text file
+      std::vector<unsigned int> solution;
+      std::string text;  // the line, if it is not a puzzle
+   };
+
+   // A queue item. Batches are reused, so their puzzles keep the memory of the earlier ones
+   struct PuzzleBatch {
+      std::uint64_t idx = 0;  // the position of the batch in the input
+      std::size_t num_puzzles = 0;  // the number of puzzles in use
+      std::vector<PipelinePuzzle> puzzles;
+   };
+
+   typedef BoundedQueue<PuzzleBatch *> BatchQueue;
+
+   double seconds_since(std::chrono::steady_clock::time_point start) {
+      return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   }
+
+   // Calls @p attempt until it succeeds or @p stop is set, adding the time spent waiting to @p waited_seconds.
+   // Returns false if stopped. A waiting thread yields at first, then sleeps, to leave the cores to the busy stages
+   template<typename Attempt>
+   bool wait_for(const Attempt &attempt, const std::atomic<bool> &stop, double &waited_seconds) {
+      if (attempt()) {
+         return true;
+      }
+      auto start = std::chrono::steady_clock::now();
+      for (unsigned int num_tries = 1; not attempt(); ++num_tries) {
+         if (stop.load(std::memory_order_acquire)) {
+            waited_seconds += seconds_since(start);
+            return false;
+         }
+         if (num_tries < 64) {
+            std::this_thread::yield();
+         } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+         }
+      }
+      waited_seconds += seconds_since(start);
+      return true;
+   }
+
+   // The source of the puzzles read by the first stage
+   class PuzzleReader {
+   public:
+      explicit PuzzleReader(const std::string &input_path) : _buffer(1u << 20) {
+         if (PuzzleCorpus::is_corpus_file(input_path)) {
+            _corpus = std::make_unique<PuzzleCorpus>(input_path);
+            check_one_line_size(_corpus->get_size());
+         } else {
+            _text_file.rdbuf()->pubsetbuf(_buffer.data(), static_cast<std::streamsize>(_buffer.size()));
+            _text_file.open(input_path, std::ios::binary);
+         }
+      }
+
+      // Reads the next puzzle into @p puzzle. Returns false at the end of the input
+      bool read(PipelinePuzzle &puzzle) {
+         puzzle.is_solved = false;
+         if (_corpus) {
+            if (_record_idx == _corpus->count()) {
+               return false;
+            }
+            puzzle.size = _corpus->get_size();
+            puzzle.record_idx = _record_idx++;
+            return true;
+         }
+         while (std::getline(_text_file, _line)) {
+            if (not is_blank_line(_line.data(), _line.data() + _line.size())) {
+               // only the first field is the puzzle, the rest of the line (for example a solution) is ignored
+               const char *field = _line.data();
+               puzzle.size = read_one_line_field(field, _line.data() + _line.size(), puzzle.tiles);
+               if (puzzle.size == 0) {
+                  puzzle.text = _line;
+               }
+               return true;
+            }
+         }
+         return false;
+      }
+
+      // The input if it is a corpus, null for a text file
+      const PuzzleCorpus *corpus() const { return _corpus.get(); }
+
+   private:
+      std::vector<char> _buffer;  // the buffer of the text file, larger than the default
+      std::ifstream _text_file;
+      std::unique_ptr<PuzzleCorpus> _corpus;  // the input if it is a corpus, null for a text file
+      std::uint64_t _record_idx = 0;  // the next record of the corpus
+      std::string _line;
+   };
+
+   // The state shared by the stages of a run
+   struct Pipeline {
+      const PuzzleCorpus *corpus;  // the input if it is a corpus, whose records are decoded directly by the solvers
+      std::vector<std::unique_ptr<PuzzleBatch>> batches;  // the pool of batches
+      BatchQueue free_batches, parsed_batches, solved_batches;
+      std::atomic<bool> is_read{false};  // set by the reader after the last batch
+      std::atomic<std::uint64_t> num_batches{0};  // the number of batches of the input, valid once is_read is set
+      std::atomic<bool> stop{false};  // set when a stage fails, to stop the others
+      std::exception_ptr failure;
+      std::mutex report_mutex;
+      PipelineReport report;
+
+      Pipeline(const PuzzleCorpus *corpus_, const PipelineOptions &options, std::size_t num_batches_) :
+            corpus{corpus_}, free_batches{num_batches_}, parsed_batches{options.queue_capacity},
+            solved_batches{options.queue_capacity} {
+         for (std::size_t idx = 0; idx != num_batches_; ++idx) {
+            batches.push_back(std::make_unique<PuzzleBatch>());
+            batches.back()->puzzles.resize(options.batch_size);
+            PuzzleBatch *batch = batches.back().get();
+            free_batches.try_push(batch);
+         }
+      }
+
+      // Runs @p stage, recording its failure and its times in @p stage_report.
+      // @p stage is called with the counters of the waits, and the rest of the time of the thread is counted as busy
+      template<typename Stage>
+      void run_stage(const Stage &stage, StageReport &stage_report) {
+         auto start = std::chrono::steady_clock::now();
+         StageReport thread_report;
+         try {
+            stage(thread_report.starved_seconds, thread_report.blocked_seconds);
+         } catch (...) {
+            std::lock_guard<std::mutex> lock(report_mutex);
+            if (not failure) {
+               failure = std::current_exception();
+            }
+            stop = true;
+         }
+         std::lock_guard<std::mutex> lock(report_mutex);
+         ++stage_report.num_threads;
+         stage_report.busy_seconds +=
+               seconds_since(start) - thread_report.starved_seconds - thread_report.blocked_seconds;
+         stage_report.starved_seconds += thread_report.starved_seconds;
+         stage_report.blocked_seconds += thread_report.blocked_seconds;
+      }
+
+      void read(PuzzleReader &reader, double &, double &blocked_seconds) {
+         std::uint64_t batch_idx = 0;
+         for (bool is_end = false; not is_end;) {
+            PuzzleBatch *batch = nullptr;
+            if (not wait_for([&]() { return free_batches.try_pop(batch); }, stop, blocked_seconds)) {
+               return;
+            }
+            batch->num_puzzles = 0;
+            while (batch->num_puzzles != batch->puzzles.size()) {
+               if (not reader.read(batch->puzzles[batch->num_puzzles])) {
+                  is_end = true;
+                  break;
+               }
+               ++batch->num_puzzles;
+            }
+            if (batch->num_puzzles == 0) {
+               free_batches.try_push(batch);
+               break;
+            }
+            batch->idx = batch_idx++;
+            if (not wait_for([&]() { return parsed_batches.try_push(batch); }, stop, blocked_seconds)) {
+               return;
+            }
+         }
+         num_batches = batch_idx;
+         is_read.store(true, std::memory_order_release);
+      }
+
+      // Pops a batch from @p queue into @p batch, or sets it to null once @p is_last tells that no batch will come
+      template<typename IsLast>
+      bool pop(BatchQueue &queue, PuzzleBatch *&batch, const IsLast &is_last, double &starved_seconds) {
+         return wait_for([&]() {
+            if (queue.try_pop(batch)) {
+               return true;
+            }
+            // the batches pushed before the last one was announced must still be popped
+            if (is_last() and not queue.try_pop(batch)) {
+               batch = nullptr;
+               return true;
+            }
+            return false;
+         }, stop, starved_seconds) and batch;
+      }
+
+      void solve(double &starved_seconds, double &blocked_seconds) {
+         auto is_last = [&]() { return is_read.load(std::memory_order_acquire); };
+         for (PuzzleBatch *batch = nullptr; pop(parsed_batches, batch, is_last, starved_seconds); batch = nullptr) {
+            for (std::size_t idx = 0; idx != batch->num_puzzles; ++idx) {
+               PipelinePuzzle &puzzle = batch->puzzles[idx];
+               if (puzzle.size == 0) {
+                  continue;
+               }
+               puzzle.is_solved = corpus ? solve_puzzle(corpus->puzzle(puzzle.record_idx), puzzle.solution) :
+                                  solve_puzzle(puzzle.tiles, puzzle.solution);
+            }
+            if (not wait_for([&]() { return solved_batches.try_push(batch); }, stop, blocked_seconds)) {
+               return;
+            }
+         }
+      }
+
+      void write(std::ostream &output, double &starved_seconds, double &blocked_seconds) {
+         // the batches that arrived before their turn, by idx modulo the size of the pool (which bounds their number)
+         std::vector<PuzzleBatch *> waiting_batches(batches.size(), nullptr);
+         std::uint64_t next_idx = 0;
+         std::string text;
+         std::vector<unsigned int> tiles;
+         auto is_last = [&]() { return is_read.load(std::memory_order_acquire) and next_idx == num_batches; };
+         for (PuzzleBatch *batch = nullptr; pop(solved_batches, batch, is_last, starved_seconds); batch = nullptr) {
+            waiting_batches[batch->idx % waiting_batches.size()] = batch;
+            while ((batch = waiting_batches[next_idx % waiting_batches.size()])) {
+               waiting_batches[next_idx % waiting_batches.size()] = nullptr;
+               text.clear();
+               for (std::size_t idx = 0; idx != batch->num_puzzles; ++idx) {
+                  const PipelinePuzzle &puzzle = batch->puzzles[idx];
+                  if (puzzle.size == 0) {
+                     format_unreadable_line(puzzle.text.data(), puzzle.text.data() + puzzle.text.size(), text);
+                     continue;
+                  }
+                  const unsigned int *puzzle_tiles = puzzle.tiles.data();
+                  if (corpus) {
+                     PuzzleRecord record = corpus->puzzle(puzzle.record_idx);
+                     tiles.resize(record.num_tiles());
+                     record.unpack(tiles.data());
+                     puzzle_tiles = tiles.data();
+                  }
+                  format_solution_line(puzzle_tiles, puzzle.is_solved ? puzzle.solution.data() : nullptr, puzzle.size,
+                                       text);
+                  report.num_solved += puzzle.is_solved;
+               }
+               output.write(text.data(), static_cast<std::streamsize>(text.size()));
+               if (not output) {
+                  throw std::invalid_argument("Cannot write the solutions");
+               }
+               report.num_puzzles += batch->num_puzzles;
+               ++report.num_batches;
+               ++next_idx;
+               if (not wait_for([&]() { return free_batches.try_push(batch); }, stop, blocked_seconds)) {
+                  return;
+               }
+            }
+         }
+      }
+   };
+}
+
+PipelineReport run_pipeline(const std::string &input_path, std::ostream &output, const PipelineOptions &options) {
+   auto start = std::chrono::steady_clock::now();
+   PipelineOptions settings = options;
+   if (settings.num_solvers == 0) {
+      settings.num_solvers = std::max(1u, std::thread::hardware_concurrency());
+   }
+   settings.batch_size = std::max(1u, settings.batch_size);
+   settings.queue_capacity = std::max(1u, settings.queue_capacity);
+
+   PuzzleReader reader(input_path);
+   // enough batches to fill both queues and keep every solver busy
+   Pipeline pipeline(reader.corpus(), settings,
+                     2 * static_cast<std::size_t>(settings.queue_capacity) + settings.num_solvers + 2);
+   PipelineReport &report = pipeline.report;
+
+   std::vector<std::thread> threads;
+   threads.emplace_back([&]() {
+      pipeline.run_stage([&](double &starved_seconds, double &blocked_seconds) {
+         pipeline.read(reader, starved_seconds, blocked_seconds);
+      }, report.reader);
+   });
+   for (unsigned int solver_idx = 0; solver_idx != settings.num_solvers; ++solver_idx) {
+      threads.emplace_back([&]() {
+         pipeline.run_stage([&](double &starved_seconds, double &blocked_seconds) {
+            pipeline.solve(starved_seconds, blocked_seconds);
+         }, report.solvers);
+      });
+   }
+   pipeline.run_stage([&](double &starved_seconds, double &blocked_seconds) {
+      pipeline.write(output, starved_seconds, blocked_seconds);
+   }, report.writer);
+   for (auto &thread : threads) {
+      thread.join();
+   }
+   if (pipeline.failure) {
+      std::rethrow_exception(pipeline.failure);
+   }
+   output.flush();
+   report.seconds = seconds_since(start);
+   return report;
+}
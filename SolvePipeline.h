@@ -0,0 +1,54 @@
+//
+// Pipelined solving of a stream of puzzles
+//
+// Three stages run concurrently, connected by bounded lock-free queues of batches of puzzles:
+//
+//    reader  ->  solvers (a pool of threads)  ->  writer
+//
+// The reader parses the input (a corpus or a text file in the one-line format) into batches, the solvers solve the
+// batches in any order, and the writer formats them back in input order, one "puzzle,solution" line per puzzle
+// ("puzzle," if the puzzle cannot be solved or read). Batches come from a fixed pool and go back to it once written,
+// so a slow stage makes the stages before it wait (backpressure) and the memory in use stays bounded.
+//
+
+#ifndef SUDOKU_SOLVEPIPELINE_H
+#define SUDOKU_SOLVEPIPELINE_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// The settings of a pipeline
+struct PipelineOptions {
+   unsigned int num_solvers = 0;  // the number of solver threads, 0 means one per core
+   unsigned int batch_size = 64;  // the number of puzzles in a queue item
+   unsigned int queue_capacity = 16;  // the number of batches each queue can hold
+};
+
+// How a stage spent its time, summed over its threads
+struct StageReport {
+   unsigned int num_threads = 0;
+   double busy_seconds = 0;  // the time spent reading, solving or writing
+   double starved_seconds = 0;  // the time spent waiting for a batch from the previous stage
+   double blocked_seconds = 0;  // the time spent waiting for room in the next stage
+
+   // The fraction of the time of a run of @p seconds that the threads of the stage were busy
+   double utilization(double seconds) const { return seconds > 0 ? busy_seconds / (num_threads * seconds) : 0; }
+};
+
+// The outcome of a pipeline run
+struct PipelineReport {
+   std::uint64_t num_puzzles = 0;
+   std::uint64_t num_solved = 0;
+   std::uint64_t num_batches = 0;
+   double seconds = 0;  // the wall-clock time of the run
+   StageReport reader, solvers, writer;
+
+   double puzzles_per_second() const { return seconds > 0 ? static_cast<double>(num_puzzles) / seconds : 0; }
+};
+
+// Solves every puzzle of @p input_path (a corpus or a text file in the one-line format), writing the solutions to
+// @p output in input order
+PipelineReport run_pipeline(const std::string &input_path, std::ostream &output, const PipelineOptions &options);
+
+#endif //SUDOKU_SOLVEPIPELINE_H
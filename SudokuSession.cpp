@@ -0,0 +1,160 @@
+//
+// Implementation file for the class SudokuSession
+//
+
+#include "SudokuSession.h"
+
+#include <stdexcept>
+#include <string>
+
+const unsigned int SudokuSession::NOT_APPLIED = 0;
+
+SudokuSession::SudokuSession(std::ifstream &input_file) :
+      _sudoku{input_file}, _placed_values(_sudoku.get_size() * _sudoku.get_size(), SudokuSolver::FREE) {
+   check_givens();
+}
+
+SudokuSession::SudokuSession(const PuzzleRecord &record) :
+      _sudoku{record}, _placed_values(_sudoku.get_size() * _sudoku.get_size(), SudokuSolver::FREE) {
+   check_givens();
+}
+
+bool SudokuSession::place(Coord coord, unsigned int value) {
+   check_coord(coord);
+   if (value < 1 or value > _sudoku.get_size()) {
+      throw std::invalid_argument("Cannot place the illegal value " + std::to_string(value));
+   }
+   if (placed_value(coord) != SudokuSolver::FREE) {
+      erase(coord);
+   }
+   _moves.emplace_back(coord, value);
+   placed_value(coord) = value;
+   apply(_moves.back());
+   return _moves.back().turn != NOT_APPLIED;
+}
+
+bool SudokuSession::erase(Coord coord) {
+   check_coord(coord);
+   for (std::size_t move_idx = 0; move_idx != _moves.size(); ++move_idx) {
+      if (_moves[move_idx].coord.row_idx == coord.row_idx and _moves[move_idx].coord.col_idx == coord.col_idx) {
+         placed_value(coord) = SudokuSolver::FREE;
+         remove_move(move_idx);
+         return true;
+      }
+   }
+   return false;
+}
+
+bool SudokuSession::undo() {
+   if (_moves.empty()) {
+      return false;
+   }
+   placed_value(_moves.back().coord) = SudokuSolver::FREE;
+   remove_move(_moves.size() - 1);
+   return true;
+}
+
+std::vector<unsigned int> SudokuSession::candidates(Coord coord) const {
+   check_in_grid(coord);
+   const SudokuSolver::Tile &tile = _sudoku.tile(coord);
+   if (tile.is_fixed()) {
+      return std::vector<unsigned int>{static_cast<unsigned int>(tile.value())};
+   }
+   std::vector<unsigned int> values;
+   values.reserve(tile.num_possibilities());
+   for (unsigned int candidate_value = 1; candidate_value <= _sudoku.get_size(); ++candidate_value) {
+      if (tile.can_set_to(candidate_value)) {
+         values.push_back(candidate_value);
+      }
+   }
+   return values;
+}
+
+unsigned int SudokuSession::value(Coord coord) const {
+   check_in_grid(coord);
+   const SudokuSolver::Tile &tile = _sudoku.tile(coord);
+   return tile.get_from_input() ? static_cast<unsigned int>(tile.value()) : placed_value(coord);
+}
+
+bool SudokuSession::is_conflictual(Coord coord) const {
+   check_in_grid(coord);
+   return _sudoku.tile(coord).get_is_conflictual();
+}
+
+bool SudokuSession::hint(Coord &coord, unsigned int &value) const {
+   Coord candidate_coord;
+   for (candidate_coord.row_idx = 0; candidate_coord.row_idx != _sudoku.get_size(); ++candidate_coord.row_idx) {
+      for (candidate_coord.col_idx = 0; candidate_coord.col_idx != _sudoku.get_size(); ++candidate_coord.col_idx) {
+         const SudokuSolver::Tile &tile = _sudoku.tile(candidate_coord);
+         if (tile.is_fixed() and not tile.get_from_input() and placed_value(candidate_coord) == SudokuSolver::FREE) {
+            coord = candidate_coord;
+            value = static_cast<unsigned int>(tile.value());
+            return true;
+         }
+      }
+   }
+   return false;
+}
+
+bool SudokuSession::is_solved() const {
+   Coord coord;
+   for (coord.row_idx = 0; coord.row_idx != _sudoku.get_size(); ++coord.row_idx) {
+      for (coord.col_idx = 0; coord.col_idx != _sudoku.get_size(); ++coord.col_idx) {
+         if (value(coord) == SudokuSolver::FREE or is_conflictual(coord)) {
+            return false;
+         }
+      }
+   }
+   return true;
+}
+
+void SudokuSession::apply(Move &move) {
+   _sudoku._guesses_list.push_back(move.coord);
+   if (_sudoku.set_value(move.coord, move.value)) {
+      move.turn = _sudoku.turn();
+   } else {
+      _sudoku.remove_guess();
+      _sudoku._guesses_list.pop_back();
+      move.turn = NOT_APPLIED;
+      _sudoku.tile(move.coord).set_is_conflictual(true);
+   }
+}
+
+void SudokuSession::remove_move(std::size_t move_idx) {
+   // the turns are a stack: resetting the first turn from move_idx on also resets all the following ones
+   for (std::size_t idx = move_idx; idx != _moves.size(); ++idx) {
+      if (_moves[idx].turn != NOT_APPLIED) {
+         _sudoku._guesses_list.resize(_moves[idx].turn);
+         _sudoku.remove_guess();
+         _sudoku._guesses_list.pop_back();
+         break;
+      }
+   }
+   for (std::size_t idx = move_idx; idx != _moves.size(); ++idx) {
+      _sudoku.tile(_moves[idx].coord).set_is_conflictual(false);
+   }
+   _moves.erase(_moves.begin() + static_cast<std::ptrdiff_t>(move_idx));
+   for (std::size_t idx = move_idx; idx != _moves.size(); ++idx) {
+      apply(_moves[idx]);
+   }
+}
+
+void SudokuSession::check_givens() const {
+   // the solver stops loading the puzzle at the first conflict, so the givens after it would be missing
+   if (not _sudoku._is_solvable) {
+      throw std::invalid_argument("The values given by the puzzle conflict with each other");
+   }
+}
+
+void SudokuSession::check_in_grid(Coord coord) const {
+   if (coord.row_idx >= _sudoku.get_size() or coord.col_idx >= _sudoku.get_size()) {
+      throw std::invalid_argument("The coordinates are outside of the grid");
+   }
+}
+
+void SudokuSession::check_coord(Coord coord) const {
+   check_in_grid(coord);
+   if (_sudoku.tile(coord).get_from_input()) {
+      throw std::invalid_argument("The tile is given by the puzzle and cannot be changed");
+   }
+}
@@ -0,0 +1,95 @@
+//
+// class SudokuSession
+//
+
+#ifndef SUDOKU_SUDOKUSESSION_H
+#define SUDOKU_SUDOKUSESSION_H
+
+#include <fstream>
+#include <vector>
+#include "SudokuSolver.h"
+
+// An interactive game on a puzzle. The propagated state of the solver is kept between the moves of the player:
+// every move is applied in its own turn of the solver, so it can be undone by resetting the locks of that turn only
+class SudokuSession {
+public:
+   typedef SudokuSolver::Coord Coord;
+
+   // @p input_file is a file from which to read the puzzle. Throws if the values given by the puzzle conflict
+   explicit SudokuSession(std::ifstream &input_file);
+
+   // @p record is a packed puzzle (for example a record of a PuzzleCorpus). Throws if its values conflict
+   explicit SudokuSession(const PuzzleRecord &record);
+
+   // The player writes @p value in the tile at @p coord, replacing the value already there (if any).
+   // Throws if the coordinates or the value are out of range, or if the tile is given by the puzzle.
+   // Returns false if the value conflicts with the values already in the grid, directly or through the values they
+   // force: the tile is then flagged as conflictual, and the move is not propagated until the cause is erased
+   bool place(Coord coord, unsigned int value);
+
+   // The player erases the value at @p coord. Returns false if the player did not write a value there
+   bool erase(Coord coord);
+
+   // Undoes the last move of the player. Returns false if there are no moves
+   bool undo();
+
+   // The values that can still be written in the tile at @p coord. Just the value of the tile if it is fixed.
+   // Like all the queries on a tile, throws if the coordinates are out of range
+   std::vector<unsigned int> candidates(Coord coord) const;
+
+   // The value written in the tile at @p coord by the puzzle or by the player (FREE if there is none)
+   unsigned int value(Coord coord) const;
+
+   // Tells if the value in the tile at @p coord conflicts with the rest of the grid
+   bool is_conflictual(Coord coord) const;
+
+   // Finds a tile without a value whose value is forced by the values in the grid.
+   // Returns false if there is no such tile
+   bool hint(Coord &coord, unsigned int &value) const;
+
+   // Tells if every tile has a value, and there are no conflicts
+   bool is_solved() const;
+
+   const SudokuSolver &sudoku() const { return _sudoku; }
+
+private:
+   struct Move {
+      Coord coord;
+      unsigned int value;
+      unsigned int turn;  // the turn of the solver in which the move was applied, NOT_APPLIED if it is conflictual
+
+      Move(Coord coord_, unsigned int value_) : coord{coord_}, value{value_}, turn{NOT_APPLIED} {}
+   };
+
+   static const unsigned int NOT_APPLIED;
+
+   // Applies @p move in a new turn of the solver. If it brings to a conflict, the turn is reset and the tile flagged
+   void apply(Move &move);
+
+   // Removes the move of index @p move_idx, resetting the turns of it and all the following moves,
+   // which are then applied again
+   void remove_move(std::size_t move_idx);
+
+   // Throws if the solver proved that the values given by the puzzle conflict
+   void check_givens() const;
+
+   // Checks that @p coord is in the grid
+   void check_in_grid(Coord coord) const;
+
+   // Checks that @p coord is in the grid and not given by the puzzle
+   void check_coord(Coord coord) const;
+
+   unsigned int &placed_value(Coord coord) {
+      return _placed_values[coord.row_idx * _sudoku.get_size() + coord.col_idx];
+   }
+
+   unsigned int placed_value(Coord coord) const {
+      return _placed_values[coord.row_idx * _sudoku.get_size() + coord.col_idx];
+   }
+
+   SudokuSolver _sudoku;  // The solver holding the propagated state
+   std::vector<Move> _moves;  // The moves of the player still in the grid, in the order they were made
+   std::vector<unsigned int> _placed_values;  // The value written by the player in each tile, FREE if none
+};
+
+#endif //SUDOKU_SUDOKUSESSION_H
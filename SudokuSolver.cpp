@@ -4,64 +4,62 @@
 //
 
 #include "SudokuSolver.h"
+#include "PuzzleCorpus.h"
+
+#include <algorithm>
 
 const unsigned int SudokuSolver::FREE = 0;
-const int SudokuSolver::AVAILABLE = -1;
+const SudokuSolver::Stamp SudokuSolver::AVAILABLE = std::numeric_limits<SudokuSolver::Stamp>::max();
+const unsigned int SudokuSolver::MAX_SIZE = 255;
 
-SudokuSolver::SudokuSolver(std::ifstream &input_file) : _is_solvable{true} {
+SudokuSolver::SudokuSolver(std::ifstream &input_file) {
    constructor_function(input_file);
 }
 
-bool SudokuSolver::has_legal_solution() const {
-   Coord coord;
-   for (coord.row_idx = 0; coord.row_idx != _size; ++coord.row_idx) {
-      for (coord.col_idx = 0; coord.col_idx != _size; ++coord.col_idx) {
-         if (not tile(coord).has_legal_value()) {
-            return false;
-         }
-      }
-   }
+SudokuSolver::SudokuSolver(const PuzzleRecord &record) {
+   constructor_function(record);
+}
 
-   std::vector<bool> contained_values(_size, false);
-   auto reset_contained_values = [&]() {
-      for (unsigned int idx = 0; idx != _size; ++idx) {
-         contained_values[idx] = false;
-      }
-   };
-   auto all_values_are_contained = [&]() -> bool {
-      for (const auto &val : contained_values) {
-         if (not val) {
-            return false;
-         }
-      }
-      return true;
-   };
+SudokuSolver::SudokuSolver(const std::vector<unsigned int> &tiles) {
+   constructor_function(tiles);
+}
 
-   for (coord.row_idx = 0; coord.row_idx != _size; ++coord.row_idx) {
-      reset_contained_values();
-      for (coord.col_idx = 0; coord.col_idx != _size; ++coord.col_idx) {
-         contained_values[tile(coord).value() - 1] = true;
-      }
-      if (not all_values_are_contained()) {
-         return false;
-      }
-   }
-   for (coord.col_idx = 0; coord.col_idx != _size; ++coord.col_idx) {
-      reset_contained_values();
-      for (coord.row_idx = 0; coord.row_idx != _size; ++coord.row_idx) {
-         contained_values[tile(coord).value() - 1] = true;
-      }
-      if (not all_values_are_contained()) {
-         return false;
-      }
-   }
-   for (unsigned int idx_ext = 0; idx_ext != _size; ++idx_ext) {
-      reset_contained_values();
-      for (unsigned int idx_int = 0; idx_int != _size; ++idx_int) {
-         contained_values[_matrix[(idx_ext / _region_size) * _region_size + (idx_int / _region_size)]
-                          [(idx_ext % _region_size) * _region_size + (idx_int % _region_size)].value() - 1] = true;
-      }
-      if (not all_values_are_contained()) {
+unsigned int SudokuSolver::count_solutions(unsigned int limit, std::uint64_t max_guesses) {
+   _solution_limit = limit;
+   _num_solutions = 0;
+   _max_guesses = max_guesses;
+   _num_guesses = 0;
+   _is_out_of_guesses = false;
+   if (_is_solvable) {
+      guess();
+   }
+   _solution_limit = 1;
+   _max_guesses = 0;
+   return _num_solutions;
+}
+
+void SudokuSolver::randomize_guesses(unsigned int seed) {
+   _randomize_guesses = true;
+   _random_engine.seed(seed);
+}
+
+bool SudokuSolver::has_legal_solution() const {
+   // the values already found in each unit, as packed bitsets filled with a single pass. Up to size 64 (a word per
+   // unit) they fit on the stack; larger grids, whose solving costs far more than an allocation, use the heap
+   Word stack_seen[3 * 64];
+   std::vector<Word> heap_seen;
+   std::size_t num_words = static_cast<std::size_t>(3) * _size * words_per_tile();
+   Word *seen = stack_seen;
+   if (num_words > sizeof(stack_seen) / sizeof(Word)) {
+      heap_seen.resize(num_words);
+      seen = heap_seen.data();
+   }
+   std::fill_n(seen, num_words, 0);
+
+   for (unsigned int tile_idx = 0; tile_idx != _matrix.size(); ++tile_idx) {
+      if (not tile(tile_idx).has_legal_value() or
+          _topology->mark_seen(seen, tile_idx, static_cast<unsigned int>(tile(tile_idx).value() - 1)) !=
+          SudokuTopology::NOT_SEEN) {
          return false;
       }
    }
@@ -73,7 +71,38 @@ void SudokuSolver::constructor_function(std::ifstream &input_file) {
    if (input_numbers.empty()) {
       throw std::invalid_argument("The input file does not contain a grid. See the README file");
    }
-   _num_free_tiles = static_cast<unsigned int>(input_numbers.size());
+   constructor_function(input_numbers);
+}
+
+void SudokuSolver::constructor_function(const PuzzleRecord &record) {
+   allocate_grid(record.num_tiles());
+
+   Coord cd;
+   unsigned int tile_idx = 0;
+   for (cd.row_idx = 0; cd.row_idx != _size; ++cd.row_idx) {
+      for (cd.col_idx = 0; cd.col_idx != _size; ++cd.col_idx) {
+         if (not set_input_value(cd, record.tile(tile_idx++))) {
+            return;
+         }
+      }
+   }
+}
+
+void SudokuSolver::constructor_function(const std::vector<unsigned int> &tiles) {
+   allocate_grid(static_cast<unsigned int>(tiles.size()));
+
+   Coord cd;
+   for (cd.row_idx = 0; cd.row_idx != _size; ++cd.row_idx) {
+      for (cd.col_idx = 0; cd.col_idx != _size; ++cd.col_idx) {
+         if (not set_input_value(cd, tiles[cd.row_idx * _size + cd.col_idx])) {
+            return;
+         }
+      }
+   }
+}
+
+void SudokuSolver::allocate_grid(unsigned int num_tiles) {
+   _num_free_tiles = num_tiles;
    if (not is_positive_square(_num_free_tiles)) {
       throw std::invalid_argument("The input file does not have a number of values in form n^4 for n > 0 integer");
    }
@@ -81,104 +110,67 @@ void SudokuSolver::constructor_function(std::ifstream &input_file) {
    if (not is_positive_square(_size)) {
       throw std::invalid_argument("The input file does not have a number of values in form n^4 for n > 0 integer");
    }
+   if (_size > MAX_SIZE) {
+      throw std::invalid_argument("The input grid is too large, the maximum size is " + std::to_string(MAX_SIZE));
+   }
    _region_size = static_cast<unsigned int>(std::sqrt(_size));
+   _topology = SudokuTopology::of_size(_size);
 
-   _matrix = std::vector<std::vector<Tile>>(_size, std::vector<Tile>(_size, Tile(_size)));
-   _geo_blocks.reserve(_size);
-   for (unsigned int value = 1; value <= _size; ++value) {
-      _geo_blocks.emplace_back(std::array<std::vector<GeoBlock>, 3>{});
-      for (unsigned int dir = 0; dir != 3; ++dir) {
-         _geo_blocks.back()[dir].reserve(_size);
-         for (unsigned int idx = 0; idx != _size; ++idx) {
-            _geo_blocks.back()[dir].emplace_back(*this, static_cast<GeoDir>(dir), idx);
-         }
-      }
+   // All the per-tile and per-block storage lives in three flat pools, so that no tile or block owns heap memory
+   _tile_turns.assign(static_cast<std::size_t>(_num_free_tiles) * _size, AVAILABLE);
+   _tile_candidates.assign(static_cast<std::size_t>(_num_free_tiles) * words_per_tile(), 0);
+   _geo_block_turns.assign(static_cast<std::size_t>(_size) * 3 * _size * _size, AVAILABLE);
+
+   _matrix.reserve(_num_free_tiles);
+   for (std::size_t tile_idx = 0; tile_idx != _num_free_tiles; ++tile_idx) {
+      _matrix.emplace_back(_size, &_tile_turns[tile_idx * _size], &_tile_candidates[tile_idx * words_per_tile()]);
+   }
+   _geo_blocks.reserve(static_cast<std::size_t>(_size) * 3 * _size);
+   for (std::size_t block_idx = 0; block_idx != static_cast<std::size_t>(_size) * 3 * _size; ++block_idx) {
+      _geo_blocks.emplace_back(&_geo_block_turns[block_idx * _size], _size);
    }
+}
 
-   Coord cd;
-   for (cd.row_idx = 0; cd.row_idx != _size; ++cd.row_idx) {
-      for (cd.col_idx = 0; cd.col_idx != _size; ++cd.col_idx) {
-         if (input_numbers[cd.row_idx * _size + cd.col_idx] != 0) {
-            tile(cd).set_from_input(true);
-            if (not set_value(cd, input_numbers[cd.row_idx * _size + cd.col_idx])) {
-               _is_solvable = false;
-               tile(cd).set_is_conflictual(true);
-               return;
-            }
-         }
+bool SudokuSolver::set_input_value(SudokuSolver::Coord coord, unsigned int value) {
+   if (value != 0) {
+      tile(coord).set_from_input(true);
+      if (not set_value(coord, value)) {
+         _is_solvable = false;
+         tile(coord).set_is_conflictual(true);
+         return false;
       }
    }
+   return true;
 }
 
 bool SudokuSolver::set_value(SudokuSolver::Coord coord, unsigned int value) {
-   if (not tile(coord).can_set_to(value)) {
+   unsigned int tile_idx = tile_index(coord);
+   if (not tile(tile_idx).can_set_to(value)) {
       return false;
    }
-   if (tile(coord).is_fixed()) {
+   if (tile(tile_idx).is_fixed()) {
       return true;
    }
 
-   tile(coord).set_to_value(value, turn());
+   tile(tile_idx).set_to_value(value, turn());
    for (unsigned int forbidden_value = 1; forbidden_value <= _size; ++forbidden_value) {
-      lock_all_geo_blocks(coord, forbidden_value);
-   }
-   for (unsigned int idx = 0; idx != _size; ++idx) {
-      if (idx != coord.row_idx) {
-         lock_all_geo_blocks(Coord{idx, coord.col_idx}, value);
-      }
-      if (idx != coord.col_idx) {
-         lock_all_geo_blocks(Coord{coord.row_idx, idx}, value);
-      }
+      lock_all_geo_blocks(tile_idx, forbidden_value);
    }
-   for (unsigned int row_idx = (coord.row_idx / _region_size) * _region_size;
-        row_idx != (coord.row_idx / _region_size + 1) * _region_size; ++row_idx) {
-      if (row_idx == coord.row_idx) continue;
-      for (unsigned int col_idx = (coord.col_idx / _region_size) * _region_size;
-           col_idx != (coord.col_idx / _region_size + 1) * _region_size; ++col_idx) {
-         if (col_idx == coord.col_idx) continue;
-         lock_all_geo_blocks(Coord{row_idx, col_idx}, value);
-      }
+   const SudokuTopology::Index *peers = _topology->peers(tile_idx);
+   for (unsigned int peer = 0; peer != _topology->num_peers(); ++peer) {
+      lock_all_geo_blocks(peers[peer], value);
    }
    --_num_free_tiles;
 
-   for (unsigned int idx = 0; idx != _size; ++idx) {
-      if (idx != coord.row_idx) {
-         if (not _matrix[idx][coord.col_idx].lock_possible_value(value, turn())) {
-            return false;
-         }
-         if (_matrix[idx][coord.col_idx].num_possibilities() == 1 and not _matrix[idx][coord.col_idx].is_fixed()) {
-            if (not set_value(Coord{idx, coord.col_idx}, _matrix[idx][coord.col_idx].first_choice_available())) {
-               return false;
-            }
-         }
+   for (unsigned int peer = 0; peer != _topology->num_peers(); ++peer) {
+      Tile &peer_tile = tile(peers[peer]);
+      if (not peer_tile.lock_possible_value(value, turn())) {
+         return false;
       }
-      if (idx != coord.col_idx) {
-         if (not _matrix[coord.row_idx][idx].lock_possible_value(value, turn())) {
+      if (peer_tile.num_possibilities() == 1 and not peer_tile.is_fixed()) {
+         if (not set_value(coord_of(peers[peer]), peer_tile.first_choice_available())) {
             return false;
          }
-         if (_matrix[coord.row_idx][idx].num_possibilities() == 1 and not _matrix[coord.row_idx][idx].is_fixed()) {
-            if (not set_value(Coord{coord.row_idx, idx}, _matrix[coord.row_idx][idx].first_choice_available())) {
-               return false;
-            }
-         }
-      }
-   }
-   for (unsigned int idx_row = _region_size * (coord.row_idx / _region_size);
-        idx_row != _region_size * (coord.row_idx / _region_size + 1); ++idx_row) {
-      if (idx_row != coord.row_idx) {
-         for (unsigned int idx_col = _region_size * (coord.col_idx / _region_size);
-              idx_col != _region_size * (coord.col_idx / _region_size + 1); ++idx_col) {
-            if (idx_col != coord.col_idx) {
-               if (not _matrix[idx_row][idx_col].lock_possible_value(value, turn())) {
-                  return false;
-               }
-               if (_matrix[idx_row][idx_col].num_possibilities() == 1 and not _matrix[idx_row][idx_col].is_fixed()) {
-                  if (not set_value(Coord{idx_row, idx_col}, _matrix[idx_row][idx_col].first_choice_available())) {
-                     return false;
-                  }
-               }
-            }
-         }
       }
    }
    return true;
@@ -186,48 +178,56 @@ bool SudokuSolver::set_value(SudokuSolver::Coord coord, unsigned int value) {
 
 bool SudokuSolver::guess() {
    if (_num_free_tiles == 0) {
+      return ++_num_solutions >= _solution_limit;
+   }
+   if (_max_guesses != 0 and _num_guesses++ == _max_guesses) {
+      _is_out_of_guesses = true;  // unwinds the search as if the limit was reached
       return true;
    }
 
+   // Every attempt gets its own turn, even when it is forced, so that undoing it never touches the previous turns
    Coord tile_to_guess_coord = free_tile_with_smaller_freedom();
    Tile &tile_to_guess = tile(tile_to_guess_coord);
    GeoCoord smaller_free_geo_block_coord = free_geo_block_with_smaller_freedom();
    const GeoBlock &geo_block_to_fix = geo_block(smaller_free_geo_block_coord);
 
    if (tile_to_guess.freedom_index() <= geo_block_to_fix.freedom_index()) {
-      bool is_a_guess = (tile_to_guess.freedom_index() > 1);
+      std::vector<unsigned int> candidate_values;
       for (unsigned int candidate_value = 1; candidate_value <= _size; ++candidate_value) {
          if (tile_to_guess.can_set_to(candidate_value)) {
-            if (is_a_guess) {
-               _guesses_list.push_back(tile_to_guess_coord);
-            }
+            candidate_values.push_back(candidate_value);
+         }
+      }
+      if (_randomize_guesses) {
+         std::shuffle(candidate_values.begin(), candidate_values.end(), _random_engine);
+      }
+      for (unsigned int candidate_value : candidate_values) {
+         if (tile_to_guess.can_set_to(candidate_value)) {
+            _guesses_list.push_back(tile_to_guess_coord);
             if (set_value(tile_to_guess_coord, candidate_value) and guess()) {
                return true;
             }
             remove_guess();
-            if (is_a_guess) {
-               _guesses_list.pop_back();
-            }
+            _guesses_list.pop_back();
             if (not lock_possible_value(tile_to_guess_coord, candidate_value)) {
                return false;
             }
          }
       }
    } else {
-      bool is_a_guess = (geo_block_to_fix.freedom_index() > 1);
-      for (Coord candidate_coord : geo_block_to_fix.available_coordinates()) {
+      std::vector<Coord> candidate_coords = available_coordinates(smaller_free_geo_block_coord);
+      if (_randomize_guesses) {
+         std::shuffle(candidate_coords.begin(), candidate_coords.end(), _random_engine);
+      }
+      for (Coord candidate_coord : candidate_coords) {
          Tile &candidate_tile = tile(candidate_coord);
          if (candidate_tile.can_set_to(smaller_free_geo_block_coord.value)) {
-            if (is_a_guess) {
-               _guesses_list.push_back(tile_to_guess_coord);
-            }
+            _guesses_list.push_back(candidate_coord);
             if (set_value(candidate_coord, smaller_free_geo_block_coord.value) and guess()) {
                return true;
             }
             remove_guess();
-            if (is_a_guess) {
-               _guesses_list.pop_back();
-            }
+            _guesses_list.pop_back();
          }
       }
    }
@@ -235,47 +235,38 @@ bool SudokuSolver::guess() {
 }
 
 void SudokuSolver::remove_guess() {
-   Coord coord;
-   for (coord.row_idx = 0; coord.row_idx != _size; ++coord.row_idx) {
-      for (coord.col_idx = 0; coord.col_idx != _size; ++coord.col_idx) {
-         if (tile(coord).reset_from_turn(turn())) {
-            ++_num_free_tiles;
-         }
+   for (auto &tile_to_reset : _matrix) {
+      if (tile_to_reset.reset_from_turn(turn())) {
+         ++_num_free_tiles;
       }
    }
-   for (auto &block : _geo_blocks) {
-      for (auto &dir : block) {
-         for (auto &geo_unity : dir) {
-            geo_unity.reset_from_turn(turn());
-         }
-      }
+   for (auto &geo_unity : _geo_blocks) {
+      geo_unity.reset_from_turn(turn());
    }
 }
 
 SudokuSolver::Coord SudokuSolver::free_tile_with_smaller_freedom() const {
-   Coord tile_min_freedom{0, 0}, candidate_tile{0, 0};
+   unsigned int tile_min_freedom = 0;
    auto min_freedom = std::numeric_limits<unsigned int>::max();
-   for (candidate_tile.row_idx = 0; candidate_tile.row_idx != _size; ++candidate_tile.row_idx) {
-      for (candidate_tile.col_idx = 0; candidate_tile.col_idx != _size; ++candidate_tile.col_idx) {
-         unsigned int candidate_freedom = tile(candidate_tile).freedom_index();
-         if (candidate_freedom < min_freedom) {
-            tile_min_freedom = candidate_tile;
-            min_freedom = candidate_freedom;
-         }
+   for (unsigned int candidate_tile = 0; candidate_tile != _matrix.size(); ++candidate_tile) {
+      unsigned int candidate_freedom = _matrix[candidate_tile].freedom_index();
+      if (candidate_freedom < min_freedom) {
+         tile_min_freedom = candidate_tile;
+         min_freedom = candidate_freedom;
       }
    }
-   return tile_min_freedom;
+   return coord_of(tile_min_freedom);
 }
 
 SudokuSolver::GeoCoord SudokuSolver::free_geo_block_with_smaller_freedom() const {
    GeoCoord geo_coord_min_freedom{0, 0, 0}, candidate_geo_coord{0, 0, 0};
    unsigned int min_freedom = std::numeric_limits<unsigned int>::max(), candidate_freedom = 0;
+   auto candidate_block = _geo_blocks.begin();  // _geo_blocks is visited in the same order of the loops
    for (candidate_geo_coord.value = 1; candidate_geo_coord.value <= _size; ++candidate_geo_coord.value) {
       for (unsigned int dir_idx = 0; dir_idx != 3; ++dir_idx) {
          candidate_geo_coord.dir = static_cast<GeoDir>(dir_idx);
          for (candidate_geo_coord.idx = 0; candidate_geo_coord.idx != _size; ++candidate_geo_coord.idx) {
-            candidate_freedom = _geo_blocks[candidate_geo_coord.value -
-                                            1][dir_idx][candidate_geo_coord.idx].freedom_index();
+            candidate_freedom = (candidate_block++)->freedom_index();
             if (candidate_freedom < min_freedom) {
                geo_coord_min_freedom = candidate_geo_coord;
                min_freedom = candidate_freedom;
@@ -287,90 +278,58 @@ SudokuSolver::GeoCoord SudokuSolver::free_geo_block_with_smaller_freedom() const
 }
 
 bool SudokuSolver::lock_possible_value(Coord coord, unsigned int val) {
-   if (not tile(coord).lock_possible_value(val, turn())) {
+   unsigned int tile_idx = tile_index(coord);
+   if (not tile(tile_idx).lock_possible_value(val, turn())) {
       return false;
    }
 
-   bool should_propagate = false;
-   unsigned int other_entry = _size;
-   for (unsigned int idx = 0; idx != _size; ++idx) {
-      if (_matrix[coord.row_idx][idx].can_set_to(val)) {
-         if (other_entry < _size) {
-            should_propagate = false;
-            break;
-         } else {
-            should_propagate = true;
-            other_entry = idx;
+   // in each of the units of the tile, @p val might be left with a single place
+   for (unsigned int dir = 0; dir != 3; ++dir) {
+      const SudokuTopology::Index *unit_tiles = _topology->unit_tiles(dir, _topology->unit(tile_idx, dir));
+      bool should_propagate = false;
+      unsigned int other_entry = _size;
+      for (unsigned int idx = 0; idx != _size; ++idx) {
+         if (tile(unit_tiles[idx]).can_set_to(val)) {
+            if (other_entry < _size) {
+               should_propagate = false;
+               break;
+            } else {
+               should_propagate = true;
+               other_entry = idx;
+            }
          }
       }
-   }
-
-   if (other_entry == _size) {
-      return false;
-   }
-   if (should_propagate) {
-      if (not set_value(Coord{coord.row_idx, other_entry}, val)) {
-         return false;
-      }
-   }
 
-   should_propagate = false;
-   other_entry = _size;
-   for (unsigned int idx = 0; idx != _size; ++idx) {
-      if (_matrix[idx][coord.col_idx].can_set_to(val)) {
-         if (other_entry < _size) {
-            should_propagate = false;
-            break;
-         } else {
-            should_propagate = true;
-            other_entry = idx;
-         }
-      }
-   }
-   if (other_entry == _size) {
-      return false;
-   }
-   if (should_propagate) {
-      if (not set_value(Coord{other_entry, coord.col_idx}, val)) {
+      if (other_entry == _size) {
          return false;
       }
-   }
-
-   should_propagate = false;
-   other_entry = _size;
-   for (unsigned int idx = 0; idx != _size; ++idx) {
-      if (_matrix[(coord.row_idx / _region_size) * _region_size + (idx / _region_size)][
-            (coord.row_idx % _region_size) * _region_size +
-            (idx % _region_size)].can_set_to(val)) {
-         if (other_entry < _size) {
-            should_propagate = false;
-            break;
-         } else {
-            should_propagate = true;
-            other_entry = idx;
+      if (should_propagate) {
+         if (not set_value(coord_of(unit_tiles[other_entry]), val)) {
+            return false;
          }
       }
    }
-   if (other_entry == _size) {
-      return false;
-   }
-   if (should_propagate) {
-      if (not set_value(Coord{(coord.row_idx / _region_size) * _region_size + (other_entry / _region_size),
-                              (coord.row_idx % _region_size) * _region_size + (other_entry % _region_size)}, val)) {
-         return false;
-      }
-   }
-
    return true;
 }
 
-void SudokuSolver::lock_all_geo_blocks(SudokuSolver::Coord coord, unsigned int value) {
-   _geo_blocks[value - 1][0][coord.row_idx].lock_possible_value(coord.col_idx, turn());
-   _geo_blocks[value - 1][1][coord.col_idx].lock_possible_value(coord.row_idx, turn());
-   std::pair<unsigned int, unsigned int> region_ind = region_indices(coord);
-   _geo_blocks[value - 1][2][region_ind.first].lock_possible_value(region_ind.second, turn());
+void SudokuSolver::lock_all_geo_blocks(unsigned int tile_idx, unsigned int value) {
+   for (unsigned int dir = 0; dir != 3; ++dir) {
+      geo_block(GeoCoord{value, dir, _topology->unit(tile_idx, dir)}).lock_possible_value(
+            _topology->slot(tile_idx, dir), turn());
+   }
 }
 
+std::vector<SudokuSolver::Coord> SudokuSolver::available_coordinates(GeoCoord cd) const {
+   std::vector<SudokuSolver::Coord> output_vec;
+   const GeoBlock &block = geo_block(cd);
+   const SudokuTopology::Index *unit_tiles = _topology->unit_tiles(cd.dir, cd.idx);
+   for (unsigned int inner_idx = 0; inner_idx != block.size(); ++inner_idx) {
+      if (block.is_available(inner_idx)) {
+         output_vec.push_back(coord_of(unit_tiles[inner_idx]));
+      }
+   }
+   return output_vec;
+}
 
 std::vector<unsigned int> SudokuSolver::read_input_file(std::ifstream &input_file) {
    std::vector<unsigned int> input_numbers;
@@ -391,19 +350,27 @@ bool SudokuSolver::is_positive_square(unsigned int n) {
 
 ////////////////////////////////////////                  Tile                  ////////////////////////////////////////
 
-SudokuSolver::Tile::Tile(unsigned int grid_size_) : _value{FREE}, _from_input{false}, _is_conflictual{false},
-                                                    _grid_size{grid_size_}, _locking_turn(grid_size_, AVAILABLE) {}
+SudokuSolver::Tile::Tile(unsigned int grid_size_, Stamp *locking_turn_, Word *candidates_) :
+      _locking_turn{locking_turn_}, _candidates{candidates_}, _value{FREE},
+      _num_candidates{static_cast<std::uint16_t>(grid_size_)}, _grid_size{static_cast<std::uint16_t>(grid_size_)},
+      _from_input{false}, _is_conflictual{false} {
+   for (unsigned int val = 1; val <= _grid_size; ++val) {
+      _candidates[(val - 1) / 64] |= Word{1} << ((val - 1) % 64);
+   }
+}
 
 bool SudokuSolver::Tile::set_to_value(unsigned int val, unsigned int turn) {
    if (not can_set_to(val) or is_fixed()) {
       return false;
    }
-   _value = val;
-   for (auto &possibility : _locking_turn) {
-      if (possibility == AVAILABLE) {
-         possibility = turn;
+   _value = static_cast<std::uint16_t>(val);
+   for (unsigned int word_idx = 0; word_idx != (_grid_size + 63u) / 64; ++word_idx) {
+      for (Word bits = _candidates[word_idx]; bits != 0; bits &= bits - 1) {
+         _locking_turn[word_idx * 64 + __builtin_ctzll(bits)] = static_cast<Stamp>(turn);
       }
+      _candidates[word_idx] = 0;
    }
+   _num_candidates = 0;
    return true;
 }
 
@@ -415,7 +382,9 @@ bool SudokuSolver::Tile::lock_possible_value(unsigned int val, unsigned int turn
       return false;
    }
    if (_locking_turn[val - 1] == AVAILABLE) {
-      _locking_turn[val - 1] = turn;
+      _locking_turn[val - 1] = static_cast<Stamp>(turn);
+      _candidates[(val - 1) / 64] &= ~(Word{1} << ((val - 1) % 64));
+      --_num_candidates;
    }
    return (num_possibilities() > 0 or is_fixed());
 }
@@ -424,20 +393,7 @@ bool SudokuSolver::Tile::can_set_to(unsigned int value) const {
    if (_value == value) {
       return true;
    }
-   return not is_fixed() and value > 0 and value <= _grid_size and _locking_turn[value - 1] == AVAILABLE;
-}
-
-unsigned int SudokuSolver::Tile::num_possibilities() const {
-   if (is_fixed()) {
-      return 1;
-   }
-   unsigned int counter = 0;
-   for (unsigned int val = 1; val <= _grid_size; ++val) {
-      if (can_set_to(val)) {
-         ++counter;
-      }
-   }
-   return counter;
+   return not is_fixed() and value > 0 and value <= _grid_size and has_candidate(value);
 }
 
 bool SudokuSolver::Tile::reset_from_turn(unsigned int turn) {
@@ -446,18 +402,22 @@ bool SudokuSolver::Tile::reset_from_turn(unsigned int turn) {
       _value = FREE;
       is_freed = true;
    }
-   for (auto &possibility : _locking_turn) {
-      if (possibility >= turn) {
-         possibility = AVAILABLE;
+   for (unsigned int idx = 0; idx != _grid_size; ++idx) {
+      if (_locking_turn[idx] != AVAILABLE and _locking_turn[idx] >= turn) {
+         _locking_turn[idx] = AVAILABLE;
+         _candidates[idx / 64] |= Word{1} << (idx % 64);
+         ++_num_candidates;
       }
    }
    return is_freed;
 }
 
 unsigned int SudokuSolver::Tile::first_choice_available() const {
-   for (unsigned int possibility = 1; possibility <= _grid_size; ++possibility) {
-      if (can_set_to(possibility)) {
-         return possibility;
+   if (not is_fixed()) {
+      for (unsigned int word_idx = 0; word_idx != (_grid_size + 63u) / 64; ++word_idx) {
+         if (_candidates[word_idx] != 0) {
+            return word_idx * 64 + __builtin_ctzll(_candidates[word_idx]) + 1;
+         }
       }
    }
    throw std::logic_error("Call to first choice available without any choice available");
@@ -465,34 +425,16 @@ unsigned int SudokuSolver::Tile::first_choice_available() const {
 
 ////////////////////////////////////////                GeoBlock                ////////////////////////////////////////
 
-SudokuSolver::GeoBlock::GeoBlock(SudokuSolver &ss, SudokuSolver::GeoDir dir_, unsigned int position_) :
-      _elements(ss._size), _num_free{ss._size}, _dir{dir_}, _position{position_},
-      _region_size{static_cast<unsigned int>(std::sqrt(ss._size))} {
-   for (unsigned other_idx = 0; other_idx != ss._size; ++other_idx) {
-      switch (dir_) {
-         case ROW: {
-            _elements[other_idx].tile = &ss.matrix()[position_][other_idx];
-            break;
-         }
-         case COL: {
-            _elements[other_idx].tile = &ss.matrix()[other_idx][position_];
-            break;
-         }
-         case REGION: {
-            _elements[other_idx].tile = &ss.matrix()[position_ / ss._region_size + other_idx / ss._region_size]
-            [position_ % ss._region_size + other_idx % ss._region_size];
-            break;
-         }
-      }
-   }
-}
+SudokuSolver::GeoBlock::GeoBlock(Stamp *locking_turn_, unsigned int size_) :
+      _locking_turn{locking_turn_}, _num_free{static_cast<std::uint16_t>(size_)},
+      _size{static_cast<std::uint16_t>(size_)} {}
 
 bool SudokuSolver::GeoBlock::lock_possible_value(unsigned int idx, unsigned int turn) {
-   if (idx >= _elements.size()) {
+   if (idx >= _size) {
       throw std::logic_error("Cannot lock value in invalid index");
    }
-   if (_elements[idx].turn == AVAILABLE) {
-      _elements[idx].turn = turn;
+   if (_locking_turn[idx] == AVAILABLE) {
+      _locking_turn[idx] = static_cast<Stamp>(turn);
       --_num_free;
       return true;
    }
@@ -500,46 +442,14 @@ bool SudokuSolver::GeoBlock::lock_possible_value(unsigned int idx, unsigned int
 }
 
 void SudokuSolver::GeoBlock::reset_from_turn(unsigned int turn) {
-   for (auto &el : _elements) {
-      if (el.turn != AVAILABLE and el.turn >= turn) {
-         el.turn = AVAILABLE;
+   for (unsigned int idx = 0; idx != _size; ++idx) {
+      if (_locking_turn[idx] != AVAILABLE and _locking_turn[idx] >= turn) {
+         _locking_turn[idx] = AVAILABLE;
          ++_num_free;
       }
    }
 }
 
-std::vector<SudokuSolver::Coord> SudokuSolver::GeoBlock::available_coordinates() const {
-   std::vector<SudokuSolver::Coord> output_vec;
-   switch (_dir) {
-      case ROW: {
-         for (unsigned int inner_idx = 0; inner_idx != size(); ++inner_idx) {
-            if (_elements[inner_idx].turn == AVAILABLE) {
-               output_vec.emplace_back(Coord{_position, inner_idx});
-            }
-         }
-         break;
-      }
-      case COL: {
-         for (unsigned int inner_idx = 0; inner_idx != size(); ++inner_idx) {
-            if (_elements[inner_idx].turn == AVAILABLE) {
-               output_vec.emplace_back(Coord{inner_idx, _position});
-            }
-         }
-         break;
-      }
-      case REGION: {
-         for (unsigned int inner_idx = 0; inner_idx != size(); ++inner_idx) {
-            if (_elements[inner_idx].turn == AVAILABLE) {
-               output_vec.emplace_back(Coord{(_position / _region_size) * _region_size + (inner_idx / _region_size),
-                                             (_position % _region_size) * _region_size + (inner_idx % _region_size)});
-            }
-         }
-         break;
-      }
-   }
-   return output_vec;
-}
-
 ////////////////////////////////////////          non-member functions          ////////////////////////////////////////
 
 std::ostream &operator<<(std::ostream &os, const SudokuSolver &sudoku) {
@@ -556,14 +466,14 @@ std::ostream &operator<<(std::ostream &os, const SudokuSolver &sudoku) {
       for (unsigned int idx_col = 0; idx_col != sudoku.get_size(); ++idx_col) {
          char separator = idx_col % sudoku.get_region_size() == 0 ? '|' : ' ';
          os << separator;
-         if (sudoku.matrix()[idx_row][idx_col].get_is_conflictual()) {
+         if (sudoku.get_tile(SudokuSolver::Coord{idx_row, idx_col}).get_is_conflictual()) {
             os << "\033[1;31m";
-         } else if (sudoku.matrix()[idx_row][idx_col].get_from_input()) {
+         } else if (sudoku.get_tile(SudokuSolver::Coord{idx_row, idx_col}).get_from_input()) {
             os << "\033[1;33m";
          } else {
             os << "\033[1;37m";
          }
-         std::string num_string = std::to_string(sudoku.matrix()[idx_row][idx_col].value());
+         std::string num_string = std::to_string(sudoku.get_tile(SudokuSolver::Coord{idx_row, idx_col}).value());
          std::string extra_space(num_digits - num_string.size(), ' ');
          os << extra_space << num_string << "\033[0m";
       }
@@ -8,8 +8,14 @@
 
 #include <fstream>
 #include <cmath>
-#include <array>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <random>
 #include <vector>
+#include "SudokuTopology.h"
+
+class PuzzleRecord;
 
 // This class will represent a sudoku of arbitrary size
 class SudokuSolver {
@@ -17,14 +23,20 @@ class SudokuSolver {
 
    class GeoBlock;
 
-   typedef std::vector<std::vector<Tile>> Matrix;  // The Sudoku matrix
+   typedef std::vector<Tile> Matrix;  // The Sudoku matrix, row by row
 
    enum GeoDir : unsigned int {
       ROW = 0, COL = 1, REGION = 2
    };
+
+   friend class SudokuSession;  // a session applies the moves of the player directly in the turns of the solver
 public:
+   typedef std::uint16_t Stamp;  // the turn in which a possibility was locked
+   typedef std::uint64_t Word;  // a block of a packed bitset
+
    static const unsigned int FREE;  // denotes the tile doesn't have a value yet
-   static const int AVAILABLE;  // denotes a possible value for the tile is still available
+   static const Stamp AVAILABLE;  // denotes a possible value for the tile is still available
+   static const unsigned int MAX_SIZE;  // the largest supported grid size (turns must fit in a Stamp)
 
    struct Coord {
       unsigned int row_idx, col_idx;
@@ -43,14 +55,42 @@ public:
    // @p input_file is a file from which to read the sudoku
    explicit SudokuSolver(std::ifstream &input_file);
 
+   // @p record is a packed grid (for example a record of a PuzzleCorpus), decoded directly into the tiles
+   explicit SudokuSolver(const PuzzleRecord &record);
+
+   // @p tiles are the values of the grid, row by row (0 for an empty tile)
+   explicit SudokuSolver(const std::vector<unsigned int> &tiles);
+
+   // The tiles and geometric blocks point into the pools of their solver, so a copy would share the pools of the
+   // original. Moving keeps the pools (and the pointers into them) valid
+   SudokuSolver(const SudokuSolver &) = delete;
+
+   SudokuSolver &operator=(const SudokuSolver &) = delete;
+
+   SudokuSolver(SudokuSolver &&) = default;
+
+   SudokuSolver &operator=(SudokuSolver &&) = default;
+
    // solves the input sudoku
    // Returns true if the sudoku was solved successfully, or false if it failed (meaning there are no solutions)
    bool solve() { return _is_solvable and guess(); }
 
+   // Counts the solutions of the sudoku, stopping as soon as @p limit of them are found (@p limit must be positive)
+   // If the limit is reached, the tiles hold the last solution found.
+   // The search also stops after @p max_guesses guesses (0 means no bound): get_is_out_of_guesses() then tells that
+   // the count is only a lower bound
+   unsigned int count_solutions(unsigned int limit, std::uint64_t max_guesses = 0);
+
+   // Tells if the last count_solutions stopped because it ran out of guesses
+   bool get_is_out_of_guesses() const { return _is_out_of_guesses; }
+
+   // Makes all the following guesses try the candidates in a random order, drawn from a generator seeded with @p seed
+   void randomize_guesses(unsigned int seed);
+
    // Checks if the current solution is legal (this should be redundant, but it is a security check)
    bool has_legal_solution() const;
 
-   const Matrix &matrix() const { return _matrix; }
+   const Tile &get_tile(Coord cd) const { return tile(cd); }
 
    unsigned int get_region_size() const { return _region_size; }
 
@@ -60,6 +100,17 @@ private:
    // The procedures called by the constructor
    void constructor_function(std::ifstream &input_file);
 
+   void constructor_function(const PuzzleRecord &record);
+
+   void constructor_function(const std::vector<unsigned int> &tiles);
+
+   // Checks that a grid of @p num_tiles tiles is a legal sudoku, and allocates all the tiles and geometric blocks
+   void allocate_grid(unsigned int num_tiles);
+
+   // Sets the input value @p value in the tile at coordinate @p coord (0 means the tile is empty)
+   // Returns false if the value conflicts with the previous ones, which makes the puzzle unsolvable
+   bool set_input_value(Coord coord, unsigned int value);
+
    // Set a required value @p val in the entry of _matrix at coordinated @p coord
    // This will call set_value for subsequent tiles that are forced by this set_value call
    // Returns true if set_value added a legal value (also considering the propagation)
@@ -84,47 +135,69 @@ private:
    // returns false if the locking brings to unfeasible solution
    bool lock_possible_value(Coord coord, unsigned int val);
 
-   // locks all the points in _geo_blocks with coordinates @p cd and required @p value
-   void lock_all_geo_blocks(Coord coord, unsigned int value);
+   // locks all the points in _geo_blocks with the tile @p tile_idx and required @p value
+   void lock_all_geo_blocks(unsigned int tile_idx, unsigned int value);
+
+   // The coordinates of tiles in the geometric block @p cd that are still free for the represented value
+   std::vector<Coord> available_coordinates(GeoCoord cd) const;
 
    // the current turn
    unsigned int turn() const { return static_cast<unsigned int>(_guesses_list.size()); }
 
-   const Tile &tile(Coord cd) const { return _matrix[cd.row_idx][cd.col_idx]; }
+   // The index of the tile at coordinate @p cd in _matrix (and in _topology)
+   unsigned int tile_index(Coord cd) const { return cd.row_idx * _size + cd.col_idx; }
+
+   Coord coord_of(unsigned int tile_idx) const {
+      return Coord{_topology->unit(tile_idx, ROW), _topology->unit(tile_idx, COL)};
+   }
+
+   const Tile &tile(Coord cd) const { return _matrix[tile_index(cd)]; }
+
+   Tile &tile(Coord cd) { return _matrix[tile_index(cd)]; }
 
-   Tile &tile(Coord cd) { return const_cast<Tile &>(static_cast<const SudokuSolver &>(*this).tile(cd)); }
+   const Tile &tile(unsigned int tile_idx) const { return _matrix[tile_idx]; }
 
-   const GeoBlock &geo_block(GeoCoord cd) const { return _geo_blocks[cd.value - 1][cd.dir][cd.idx]; }
+   Tile &tile(unsigned int tile_idx) { return _matrix[tile_idx]; }
+
+   const GeoBlock &geo_block(GeoCoord cd) const { return _geo_blocks[((cd.value - 1) * 3 + cd.dir) * _size + cd.idx]; }
 
    GeoBlock &geo_block(GeoCoord cd) {
       return const_cast<GeoBlock &>(static_cast<const SudokuSolver &>(*this).geo_block(cd));
    }
 
-   // The two indices with respect to the subdivision of the grid in regions
-   std::pair<unsigned int, unsigned int> region_indices(Coord coord) const {
-      return std::pair<unsigned int, unsigned int>{
-            (coord.row_idx / _region_size) * _region_size + (coord.col_idx / _region_size),
-            (coord.row_idx % _region_size) * _region_size + (coord.col_idx % _region_size)};
-   }
-
    // Read the numbers in input file, and records them in the output vector
    static std::vector<unsigned int> read_input_file(std::ifstream &input_file);
 
    // Tell if the input number @p n is a perfect square and n != 0
    static bool is_positive_square(unsigned int n);
 
+   // The number of Words needed for the candidate bitset of a single tile
+   unsigned int words_per_tile() const { return (_size + 63) / 64; }
+
    Matrix _matrix;  // The matrix of Tiles. Represents the Sudoku matrix
-   std::vector<std::array<std::vector<GeoBlock>, 3>> _geo_blocks;
-   unsigned int _num_free_tiles;  // The number of tiles for which the value has not been fixed yet
+   std::vector<GeoBlock> _geo_blocks;  // The geometric blocks, ordered by value, then direction, then position
+   std::shared_ptr<const SudokuTopology> _topology;  // The geometry of the grid, shared with the other solvers
+   std::vector<Stamp> _tile_turns;  // The locking turns of all the tiles, _size entries per tile
+   std::vector<Word> _tile_candidates;  // The candidate bitsets of all the tiles, words_per_tile() entries per tile
+   std::vector<Stamp> _geo_block_turns;  // The locking turns of all the geometric blocks, _size entries per block
+   unsigned int _num_free_tiles = 0;  // The number of tiles for which the value has not been fixed yet
    std::vector<Coord> _guesses_list;  // A list of the coordinates where we made "active" guesses. The list is sorted
-   bool _is_solvable;  // False if we proved there is no solution for the puzzle
-   unsigned int _region_size;  // The length of a small tile (usually 3)
-   unsigned int _size;  // The length of the matrix (usually 9)
+   bool _is_solvable = true;  // False if we proved there is no solution for the puzzle
+   unsigned int _solution_limit = 1;  // guess() stops after finding this number of solutions (usually 1)
+   unsigned int _num_solutions = 0;  // The number of solutions found by guess() so far
+   std::uint64_t _max_guesses = 0;  // guess() gives up after this number of guesses (0 means never)
+   std::uint64_t _num_guesses = 0;  // The number of guesses made by guess() so far
+   bool _is_out_of_guesses = false;  // True if guess() gave up because it reached _max_guesses
+   bool _randomize_guesses = false;  // True if guess() tries the candidates in a random order
+   std::minstd_rand _random_engine;  // The generator of the random orders of the candidates
+   unsigned int _region_size = 0;  // The length of a small tile (usually 3)
+   unsigned int _size = 0;  // The length of the matrix (usually 9)
 };
 
 class SudokuSolver::Tile {
 public:
-   explicit Tile(unsigned int grid_size_ = 0);
+   // @p locking_turn_ and @p candidates_ point to the storage of the tile inside the SudokuSolver
+   Tile(unsigned int grid_size_, Stamp *locking_turn_, Word *candidates_);
 
    // Set the tile to the required value, at time @p turn
    // The operation fails if the tile already contains a value, or if @p val is locked
@@ -150,7 +223,7 @@ public:
    }
 
    // The number of free possibilities for the tile. It is 1 if _value is fixed
-   unsigned int num_possibilities() const;
+   unsigned int num_possibilities() const { return is_fixed() ? 1 : _num_candidates; }
 
    // An index used for choosing which tile to guess.
    // Big if the _value is fixed already, or the number of free possibilities of it is free
@@ -175,17 +248,23 @@ public:
    void set_is_conflictual(bool is_conflictual_) { _is_conflictual = is_conflictual_; }
 
 private:
-   std::vector<int> _locking_turn;  // tells in which turn each possibility was locked. It is AVAILABLE if was never deleted. Will have size = _grid_size
-   unsigned int _value;  // the current value of the tile. FREE if the value is not set
+   // tells if the bit of @p val is set in _candidates
+   bool has_candidate(unsigned int val) const { return (_candidates[(val - 1) / 64] >> ((val - 1) % 64)) & 1u; }
+
+   Stamp *_locking_turn;  // tells in which turn each possibility was locked. It is AVAILABLE if was never deleted. Has _grid_size entries
+   Word *_candidates;  // bitset of the possibilities still available (bit val - 1 for val). Empty if _value is fixed
+   std::uint16_t _value;  // the current value of the tile. FREE if the value is not set
+   std::uint16_t _num_candidates;  // the number of bits set in _candidates
+   std::uint16_t _grid_size;  // the size of the grid (usually 9)
    bool _from_input;  // tells if the tile was fixed as input
    bool _is_conflictual;  // tells if the tile created a conflict at time 0 (making the puzzle impossible)
-   unsigned int _grid_size;  // the size of the grid (usually 9)
 };
 
 // A geometric block in the grid (of one GeoDir) for a fixed value
 class SudokuSolver::GeoBlock {
 public:
-   GeoBlock(SudokuSolver &ss, GeoDir dir_, unsigned int position_);
+   // @p locking_turn_ points to the storage of the geometric block inside the SudokuSolver
+   GeoBlock(Stamp *locking_turn_, unsigned int size_);
 
    // locks the represented value of entry with index @p idx at required @p turn
    bool lock_possible_value(unsigned int idx, unsigned int turn);
@@ -198,26 +277,16 @@ public:
       return _num_free == 0 ? std::numeric_limits<unsigned int>::max() : _num_free;
    }
 
-   // The coordinates of tiles in the geometric block that are still free for the represented value
-   std::vector<Coord> available_coordinates() const;
+   // tells if the entry with index @p idx can still take the represented value
+   bool is_available(unsigned int idx) const { return _locking_turn[idx] == AVAILABLE; }
 
    // The number of tiles in the geometric block
-   unsigned int size() const { return static_cast<unsigned int>(_elements.size()); }
+   unsigned int size() const { return _size; }
 
 private:
-   // a tile, together with the time in which the represented value was locked
-   struct Element {
-      const Tile *tile;
-      int turn;
-
-      explicit Element(Tile *tile_ = nullptr, int turn_ = AVAILABLE) : tile{tile_}, turn{turn_} {}
-   };
-
-   std::vector<Element> _elements;  // all the tiles in the geometric block
-   unsigned int _num_free;  // the number of tiles that can take the represented value
-   GeoDir _dir;  // the direction of the geometric block
-   unsigned int _position;  // the position of the geometric block (a number in [0, _size))
-   unsigned int _region_size;  // the minsize of the associated SudokuSolver
+   Stamp *_locking_turn;  // the turn in which the represented value was locked, for each tile of the block
+   std::uint16_t _num_free;  // the number of tiles that can take the represented value
+   std::uint16_t _size;  // the number of tiles in the geometric block
 };
 
 std::ostream &operator<<(std::ostream &os, const SudokuSolver &sudoku);
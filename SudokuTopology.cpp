@@ -0,0 +1,61 @@
+//
+// Implementation file for the class SudokuTopology
+//
+
+#include "SudokuTopology.h"
+
+#include <cmath>
+#include <map>
+#include <mutex>
+
+std::shared_ptr<const SudokuTopology> SudokuTopology::of_size(unsigned int size) {
+   static std::mutex topologies_mutex;
+   static std::map<unsigned int, std::shared_ptr<const SudokuTopology>> topologies;
+
+   std::lock_guard<std::mutex> lock(topologies_mutex);
+   std::shared_ptr<const SudokuTopology> &topology = topologies[size];
+   if (not topology) {
+      topology = std::make_shared<const SudokuTopology>(size);
+   }
+   return topology;
+}
+
+SudokuTopology::SudokuTopology(unsigned int size_) : _size{size_} {
+   auto region_size = static_cast<unsigned int>(std::sqrt(_size));
+   _num_peers = 2 * (_size - 1) + (region_size - 1) * (region_size - 1);
+   _units_of_tile.resize(3 * num_tiles());
+   _slots_of_tile.resize(3 * num_tiles());
+   _unit_tiles.resize(3 * num_tiles());
+   _peers.reserve(static_cast<std::size_t>(num_tiles()) * _num_peers);
+
+   for (unsigned int row_idx = 0; row_idx != _size; ++row_idx) {
+      for (unsigned int col_idx = 0; col_idx != _size; ++col_idx) {
+         unsigned int tile_idx = row_idx * _size + col_idx;
+         unsigned int units[3] = {row_idx, col_idx, (row_idx / region_size) * region_size + col_idx / region_size};
+         unsigned int slots[3] = {col_idx, row_idx, (row_idx % region_size) * region_size + col_idx % region_size};
+         for (unsigned int dir = 0; dir != 3; ++dir) {
+            _units_of_tile[3 * tile_idx + dir] = static_cast<Index>(units[dir]);
+            _slots_of_tile[3 * tile_idx + dir] = static_cast<Index>(slots[dir]);
+            _unit_tiles[(dir * _size + units[dir]) * _size + slots[dir]] = static_cast<Index>(tile_idx);
+         }
+
+         for (unsigned int idx = 0; idx != _size; ++idx) {
+            if (idx != row_idx) {
+               _peers.push_back(static_cast<Index>(idx * _size + col_idx));
+            }
+            if (idx != col_idx) {
+               _peers.push_back(static_cast<Index>(row_idx * _size + idx));
+            }
+         }
+         for (unsigned int peer_row = (row_idx / region_size) * region_size;
+              peer_row != (row_idx / region_size + 1) * region_size; ++peer_row) {
+            for (unsigned int peer_col = (col_idx / region_size) * region_size;
+                 peer_col != (col_idx / region_size + 1) * region_size; ++peer_col) {
+               if (peer_row != row_idx and peer_col != col_idx) {
+                  _peers.push_back(static_cast<Index>(peer_row * _size + peer_col));
+               }
+            }
+         }
+      }
+   }
+}
@@ -0,0 +1,76 @@
+//
+// class SudokuTopology
+//
+
+#ifndef SUDOKU_SUDOKUTOPOLOGY_H
+#define SUDOKU_SUDOKUTOPOLOGY_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// The geometry of a grid of a given size, as flat tables of tile indices.
+// Tiles are indexed row by row; units are the rows (direction 0), columns (direction 1) and regions (direction 2).
+// A topology never changes after it is built, so a single one is shared by all the solvers of the same size
+class SudokuTopology {
+public:
+   typedef std::uint16_t Index;  // the index of a tile. Grids have at most SudokuSolver::MAX_SIZE^2 < 2^16 tiles
+
+   static constexpr unsigned int NOT_SEEN = 3;  // returned by mark_seen for a value seen for the first time
+
+   // The topology of grids of size @p size, built at the first request and shared from then on. Thread safe
+   static std::shared_ptr<const SudokuTopology> of_size(unsigned int size);
+
+   explicit SudokuTopology(unsigned int size_);
+
+   unsigned int get_size() const { return _size; }
+
+   unsigned int num_tiles() const { return _size * _size; }
+
+   // The number of tiles sharing a unit with a tile (excluding the tile itself)
+   unsigned int num_peers() const { return _num_peers; }
+
+   // The index of the unit of direction @p dir containing the tile @p tile_idx
+   unsigned int unit(unsigned int tile_idx, unsigned int dir) const { return _units_of_tile[3 * tile_idx + dir]; }
+
+   // The position of the tile @p tile_idx inside its unit of direction @p dir
+   unsigned int slot(unsigned int tile_idx, unsigned int dir) const { return _slots_of_tile[3 * tile_idx + dir]; }
+
+   // The _size tiles of the unit @p unit_idx of direction @p dir, ordered by slot
+   const Index *unit_tiles(unsigned int dir, unsigned int unit_idx) const {
+      return &_unit_tiles[(dir * _size + unit_idx) * _size];
+   }
+
+   // The num_peers() peers of the tile @p tile_idx: first its column and row, interleaved, then the rest of its region
+   const Index *peers(unsigned int tile_idx) const { return &_peers[tile_idx * _num_peers]; }
+
+   // The number of 64-bit words of a bitset of the values of a unit
+   unsigned int words_per_unit() const { return (_size + 63) / 64; }
+
+   // Marks the value of index @p value_idx (the value minus 1) as seen in the units of the tile @p tile_idx.
+   // @p seen holds a bitset of words_per_unit() words for each unit, ordered by direction and then by unit index.
+   // Returns the first direction in which the value was already seen, or NOT_SEEN
+   unsigned int mark_seen(std::uint64_t *seen, unsigned int tile_idx, unsigned int value_idx) const {
+      const Index *units = &_units_of_tile[3 * tile_idx];
+      std::size_t num_words = words_per_unit(), word_idx = value_idx / 64;
+      std::uint64_t &row_bits = seen[units[0] * num_words + word_idx];
+      std::uint64_t &col_bits = seen[(_size + units[1]) * num_words + word_idx];
+      std::uint64_t &region_bits = seen[(2 * _size + units[2]) * num_words + word_idx];
+      std::uint64_t bit = std::uint64_t{1} << (value_idx % 64);
+      unsigned int seen_dir = (row_bits & bit) ? 0 : (col_bits & bit) ? 1 : (region_bits & bit) ? 2 : NOT_SEEN;
+      row_bits |= bit;
+      col_bits |= bit;
+      region_bits |= bit;
+      return seen_dir;
+   }
+
+private:
+   std::vector<Index> _units_of_tile;  // 3 entries per tile: its row, column and region
+   std::vector<Index> _slots_of_tile;  // 3 entries per tile: its position in its row, column and region
+   std::vector<Index> _unit_tiles;  // the tiles of each unit, _size entries per unit
+   std::vector<Index> _peers;  // the peers of each tile, _num_peers entries per tile
+   unsigned int _size;  // the length of the grid (usually 9)
+   unsigned int _num_peers;  // the number of peers of each tile
+};
+
+#endif //SUDOKU_SUDOKUTOPOLOGY_H
@@ -4,7 +4,360 @@
 
 #include <iostream>
 #include <fstream>
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <string>
 #include "SudokuSolver.h"
+#include "PuzzleCorpus.h"
+#include "SolutionValidator.h"
+#include "PuzzleGenerator.h"
+#include "SudokuSession.h"
+#include "CorpusRunner.h"
+#include "SolvePipeline.h"
+#include <sys/resource.h>
+
+namespace {
+   // Sudoku --pack [--one-line] [--solutions] [--size N] <input.txt> <output.sdk>
+   int pack_corpus(int argc, char *argv[]) {
+      PuzzleTextFormat format = PuzzleTextFormat::GRID;
+      bool with_solutions = false;
+      unsigned int size = 0;
+      int arg_idx = 2;
+      for (; arg_idx < argc and std::string(argv[arg_idx]).compare(0, 2, "--") == 0; ++arg_idx) {
+         std::string option = argv[arg_idx];
+         if (option == "--one-line") {
+            format = PuzzleTextFormat::ONE_LINE;
+         } else if (option == "--solutions") {
+            with_solutions = true;
+         } else if (option == "--size" and arg_idx + 1 < argc) {
+            size = static_cast<unsigned int>(std::stoul(argv[++arg_idx]));
+         } else {
+            throw std::invalid_argument("Unknown option \"" + option + "\" for --pack");
+         }
+      }
+      if (argc - arg_idx != 2) {
+         throw std::invalid_argument("Error! --pack needs an input text file and an output corpus file");
+      }
+      std::ifstream input_file(argv[arg_idx]);
+      if (not input_file.is_open()) {
+         throw std::invalid_argument(std::string("Cannot open the file \"") + argv[arg_idx] + "\"");
+      }
+      std::uint64_t count = convert_to_corpus(input_file, format, size, argv[arg_idx + 1], with_solutions);
+      std::cout << "Packed " << count << " puzzles into \"" << argv[arg_idx + 1] << "\"" << std::endl;
+      return 0;
+   }
+
+   // Sudoku --corpus <corpus.sdk>...
+   int solve_corpus(int argc, char *argv[]) {
+      if (argc < 3) {
+         throw std::invalid_argument("Error! --corpus needs the corpus files as arguments");
+      }
+      for (int idx = 2; idx != argc; ++idx) {
+         try {
+            PuzzleCorpus corpus(argv[idx]);
+            std::uint64_t num_solved = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (std::uint64_t record_idx = 0; record_idx != corpus.count(); ++record_idx) {
+               SudokuSolver sudoku(corpus.puzzle(record_idx));
+               if (sudoku.solve() and sudoku.has_legal_solution()) {
+                  ++num_solved;
+               }
+            }
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            std::cout << "The corpus \"" << argv[idx] << "\" has " << corpus.count() << " puzzles of size "
+                      << corpus.get_size() << ": " << num_solved << " solved, " << corpus.count() - num_solved
+                      << " cannot be solved (" << elapsed.count() << " s, "
+                      << static_cast<double>(corpus.count()) / elapsed.count() << " puzzles/s)" << std::endl;
+         } catch (std::exception &err) {
+            std::cerr << err.what() << std::endl;
+         }
+      }
+      return 0;
+   }
+
+   // Sudoku --validate [--threads N] <solutions.sdk or solutions.txt>...
+   int validate_solutions(int argc, char *argv[]) {
+      unsigned int num_threads = 0;
+      int arg_idx = 2;
+      if (arg_idx + 1 < argc and std::string(argv[arg_idx]) == "--threads") {
+         num_threads = static_cast<unsigned int>(std::stoul(argv[arg_idx + 1]));
+         arg_idx += 2;
+      }
+      if (arg_idx == argc) {
+         throw std::invalid_argument("Error! --validate needs the files with the solutions as arguments");
+      }
+      for (; arg_idx != argc; ++arg_idx) {
+         try {
+            ValidationReport report;
+            if (PuzzleCorpus::is_corpus_file(argv[arg_idx])) {
+               report = validate_corpus(PuzzleCorpus(argv[arg_idx]), num_threads);
+            } else {
+               std::ifstream input_file(argv[arg_idx], std::ios::binary);
+               std::ostringstream text;
+               text << input_file.rdbuf();
+               report = validate_one_line_text(text.str(), num_threads);
+            }
+            for (const auto &invalid_grid : report.invalid_grids) {
+               std::cout << argv[arg_idx] << ": grid " << invalid_grid.idx + 1 << ":";
+               for (const auto &error : invalid_grid.errors) {
+                  std::cout << " " << error.description() << ";";
+               }
+               std::cout << "\n";
+            }
+            std::cout << "The file \"" << argv[arg_idx] << "\" has " << report.num_grids << " grids: "
+                      << report.num_grids - report.invalid_grids.size() << " valid, " << report.invalid_grids.size()
+                      << " invalid (" << report.seconds << " s, " << report.grids_per_second() << " grids/s)"
+                      << std::endl;
+         } catch (std::exception &err) {
+            std::cerr << err.what() << std::endl;
+         }
+      }
+      return 0;
+   }
+
+   // Sudoku --generate [--size N] [--clues N] [--max-guesses N] [--count N] [--threads N] [--seed N] [--solutions]
+   //                  <output>
+   int generate(int argc, char *argv[]) {
+      unsigned int size = 9, target_clues = 0, num_threads = 0;
+      std::uint64_t max_guesses = PuzzleGenerator::DEFAULT_MAX_GUESSES_PER_CHECK, num_puzzles = 1, seed = 0;
+      bool with_solutions = false;
+      int arg_idx = 2;
+      for (; arg_idx < argc and std::string(argv[arg_idx]).compare(0, 2, "--") == 0; ++arg_idx) {
+         std::string option = argv[arg_idx];
+         if (option == "--solutions") {
+            with_solutions = true;
+         } else if (arg_idx + 1 == argc) {
+            throw std::invalid_argument("Missing value for option \"" + option + "\"");
+         } else if (option == "--size") {
+            size = static_cast<unsigned int>(std::stoul(argv[++arg_idx]));
+         } else if (option == "--clues") {
+            target_clues = static_cast<unsigned int>(std::stoul(argv[++arg_idx]));
+         } else if (option == "--max-guesses") {
+            max_guesses = std::stoull(argv[++arg_idx]);
+         } else if (option == "--count") {
+            num_puzzles = std::stoull(argv[++arg_idx]);
+         } else if (option == "--threads") {
+            num_threads = static_cast<unsigned int>(std::stoul(argv[++arg_idx]));
+         } else if (option == "--seed") {
+            seed = std::stoull(argv[++arg_idx]);
+         } else {
+            throw std::invalid_argument("Unknown option \"" + option + "\" for --generate");
+         }
+      }
+      if (argc - arg_idx != 1) {
+         throw std::invalid_argument("Error! --generate needs the output file as argument");
+      }
+
+      // a .sdk output is a corpus, anything else is a text file in the one-line format
+      std::string output_path = argv[arg_idx];
+      std::unique_ptr<PuzzleCorpusWriter> corpus;
+      std::ofstream text_file;
+      std::string line;
+      if (output_path.size() >= 4 and output_path.compare(output_path.size() - 4, 4, ".sdk") == 0) {
+         corpus = std::make_unique<PuzzleCorpusWriter>(output_path, size, with_solutions);
+      } else {
+         check_one_line_size(size);
+         text_file.open(output_path);
+         if (not text_file.is_open()) {
+            throw std::invalid_argument("Cannot create the file \"" + output_path + "\"");
+         }
+      }
+      GenerationReport report = generate_puzzles(
+            size, target_clues, max_guesses, num_puzzles, num_threads, seed,
+            [&](std::uint64_t, const std::vector<unsigned int> &puzzle, const std::vector<unsigned int> &solution) {
+               if (corpus) {
+                  corpus->append(puzzle.data(), solution.data());
+                  return;
+               }
+               line.clear();
+               format_one_line(puzzle.data(), size, line);
+               if (with_solutions) {
+                  line.push_back(',');
+                  format_one_line(solution.data(), size, line);
+               }
+               line.push_back('\n');
+               text_file << line;
+            });
+      if (corpus) {
+         corpus->close();
+      }
+      std::cout << "Generated " << report.num_puzzles << " puzzles of size " << size << " in \"" << output_path
+                << "\", with " << report.average_clues() << " clues on average (" << report.seconds << " s, "
+                << report.puzzles_per_second() << " puzzles/s)" << std::endl;
+      if (report.num_missed_targets != 0) {
+         std::cout << report.num_missed_targets << " of them have more than the target of " << target_clues << " clues"
+                   << std::endl;
+      }
+      if (report.num_out_of_guesses != 0) {
+         std::cout << report.num_out_of_guesses << " of them keep clues whose removal could not be proved safe in "
+                   << max_guesses << " guesses (see --max-guesses)" << std::endl;
+      }
+      return 0;
+   }
+
+   // Sudoku --shard-run [--threads N] [--shard-bytes N] [--max-shards N] <corpus.sdk or puzzles.txt> <output_dir>
+   int run_shards(int argc, char *argv[]) {
+      CorpusRunOptions options;
+      int arg_idx = 2;
+      for (; arg_idx < argc and std::string(argv[arg_idx]).compare(0, 2, "--") == 0; ++arg_idx) {
+         std::string option = argv[arg_idx];
+         if (arg_idx + 1 == argc) {
+            throw std::invalid_argument("Missing value for option \"" + option + "\"");
+         } else if (option == "--threads") {
+            options.num_threads = static_cast<unsigned int>(std::stoul(argv[++arg_idx]));
+         } else if (option == "--shard-bytes") {
+            options.shard_bytes = std::stoull(argv[++arg_idx]);
+         } else if (option == "--max-shards") {
+            options.max_shards = std::stoull(argv[++arg_idx]);
+         } else {
+            throw std::invalid_argument("Unknown option \"" + option + "\" for --shard-run");
+         }
+      }
+      if (argc - arg_idx != 2) {
+         throw std::invalid_argument("Error! --shard-run needs an input file and an output directory");
+      }
+      CorpusRunReport report = run_corpus(argv[arg_idx], argv[arg_idx + 1], options);
+      std::cout << "Finished " << report.num_finished_shards << " of " << report.num_shards << " shards ("
+                << report.num_resumed_shards << " by earlier runs): " << report.num_puzzles << " puzzles, "
+                << report.num_solved << " solved, " << report.num_puzzles - report.num_solved
+                << " cannot be solved (" << report.shard_seconds << " s in the shards)\n"
+                << "This run solved " << report.num_puzzles_this_run << " puzzles (" << report.seconds << " s, "
+                << report.puzzles_per_second() << " puzzles/s)" << std::endl;
+      if (report.is_merged) {
+         std::cout << "The solutions are in \"" << argv[arg_idx + 1] << "/solutions.txt\"" << std::endl;
+      } else {
+         std::cout << "Run the same command again to resume" << std::endl;
+      }
+      return 0;
+   }
+
+   // Sudoku --pipeline [--threads N] [--batch N] [--queue N] <corpus.sdk or puzzles.txt> <solutions.txt>
+   int pipeline(int argc, char *argv[]) {
+      PipelineOptions options;
+      int arg_idx = 2;
+      for (; arg_idx < argc and std::string(argv[arg_idx]).compare(0, 2, "--") == 0; ++arg_idx) {
+         std::string option = argv[arg_idx];
+         if (arg_idx + 1 == argc) {
+            throw std::invalid_argument("Missing value for option \"" + option + "\"");
+         } else if (option == "--threads") {
+            options.num_solvers = static_cast<unsigned int>(std::stoul(argv[++arg_idx]));
+         } else if (option == "--batch") {
+            options.batch_size = static_cast<unsigned int>(std::stoul(argv[++arg_idx]));
+         } else if (option == "--queue") {
+            options.queue_capacity = static_cast<unsigned int>(std::stoul(argv[++arg_idx]));
+         } else {
+            throw std::invalid_argument("Unknown option \"" + option + "\" for --pipeline");
+         }
+      }
+      if (argc - arg_idx != 2) {
+         throw std::invalid_argument("Error! --pipeline needs an input file and an output file");
+      }
+      std::ofstream output_file(argv[arg_idx + 1], std::ios::binary);
+      if (not output_file.is_open()) {
+         throw std::invalid_argument(std::string("Cannot create the file \"") + argv[arg_idx + 1] + "\"");
+      }
+      PipelineReport report = run_pipeline(argv[arg_idx], output_file, options);
+      std::cout << "Solved " << report.num_solved << " of " << report.num_puzzles << " puzzles in "
+                << report.num_batches << " batches (" << report.seconds << " s, " << report.puzzles_per_second()
+                << " puzzles/s)\n";
+      // the stage with the highest utilization limits the throughput
+      const std::pair<const char *, const StageReport *> stages[] = {
+            {"reader", &report.reader}, {"solvers", &report.solvers}, {"writer", &report.writer}};
+      for (const auto &stage : stages) {
+         std::cout << stage.first << " (" << stage.second->num_threads << " threads): "
+                   << 100 * stage.second->utilization(report.seconds) << "% busy, waited "
+                   << stage.second->starved_seconds << " s for input and " << stage.second->blocked_seconds
+                   << " s for output\n";
+      }
+      std::cout << std::flush;
+      return 0;
+   }
+
+   // Sudoku --bench-construction [sizes...]
+   int bench_construction(int argc, char *argv[]) {
+      std::vector<unsigned int> sizes;
+      for (int arg_idx = 2; arg_idx < argc; ++arg_idx) {
+         sizes.push_back(static_cast<unsigned int>(std::stoul(argv[arg_idx])));
+      }
+      if (sizes.empty()) {
+         sizes = {36, 49, 64, 81, 100};
+      }
+      // the peak is that of the whole process, so the sizes are best given in increasing order
+      for (unsigned int size : sizes) {
+         std::vector<unsigned int> tiles(static_cast<std::size_t>(size) * size, SudokuSolver::FREE);
+         auto start = std::chrono::steady_clock::now();
+         SudokuSolver sudoku(tiles);
+         std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+         struct rusage usage{};
+         ::getrusage(RUSAGE_SELF, &usage);
+         std::cout << "Empty grid of size " << sudoku.get_size() << ": built in " << elapsed.count()
+                   << " ms, peak resident memory " << usage.ru_maxrss / 1024.0 << " MB" << std::endl;
+      }
+      return 0;
+   }
+
+   // Sudoku --session <puzzle.txt>, then the commands of the player from the standard input
+   int play_session(int argc, char *argv[]) {
+      if (argc != 3) {
+         throw std::invalid_argument("Error! --session needs the file of the puzzle as argument");
+      }
+      std::ifstream input_file(argv[2]);
+      SudokuSession session(input_file);
+      input_file.close();
+      std::cout << "Commands (rows and columns count from 1): place ROW COL VALUE, erase ROW COL, undo, "
+                   "candidates ROW COL, hint, show, quit" << std::endl;
+
+      std::string line, command;
+      while (std::getline(std::cin, line)) {
+         std::istringstream command_line(line);
+         unsigned int row = 0, col = 0, value = 0;
+         if (not(command_line >> command)) {
+            continue;
+         }
+         try {
+            auto start = std::chrono::steady_clock::now();
+            if (command == "quit") {
+               break;
+            } else if (command == "place" and command_line >> row >> col >> value and row > 0 and col > 0) {
+               std::cout << (session.place(SudokuSession::Coord{row - 1, col - 1}, value) ? "ok" : "conflict");
+            } else if (command == "erase" and command_line >> row >> col and row > 0 and col > 0) {
+               std::cout << (session.erase(SudokuSession::Coord{row - 1, col - 1}) ? "ok" : "nothing to erase");
+            } else if (command == "undo") {
+               std::cout << (session.undo() ? "ok" : "nothing to undo");
+            } else if (command == "candidates" and command_line >> row >> col and row > 0 and col > 0) {
+               for (unsigned int candidate : session.candidates(SudokuSession::Coord{row - 1, col - 1})) {
+                  std::cout << candidate << " ";
+               }
+            } else if (command == "hint") {
+               SudokuSession::Coord coord;
+               if (session.hint(coord, value)) {
+                  std::cout << "row " << coord.row_idx + 1 << ", column " << coord.col_idx + 1 << " is " << value;
+               } else {
+                  std::cout << "no hint available";
+               }
+            } else if (command == "show") {
+               // the values of the puzzle and of the player, with the conflictual ones followed by '!'
+               SudokuSession::Coord coord;
+               for (coord.row_idx = 0; coord.row_idx != session.sudoku().get_size(); ++coord.row_idx) {
+                  for (coord.col_idx = 0; coord.col_idx != session.sudoku().get_size(); ++coord.col_idx) {
+                     std::cout << session.value(coord) << (session.is_conflictual(coord) ? "! " : " ");
+                  }
+                  std::cout << "\n";
+               }
+               std::cout << (session.is_solved() ? "solved" : "not solved yet");
+            } else {
+               std::cout << "unknown command \"" << line << "\"";
+            }
+            std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+            std::cout << " (" << elapsed.count() << " us)" << std::endl;
+         } catch (std::exception &err) {
+            std::cout << err.what() << std::endl;
+         }
+      }
+      return 0;
+   }
+}
 
 int main(int argc, char *argv[]) {
    std::ifstream input_file;
@@ -12,6 +365,38 @@ int main(int argc, char *argv[]) {
       throw std::invalid_argument("Error! Need the input files as arguments");
    }
 
+   std::string mode = argv[1];
+   // the modes other than the default one report their errors and stop
+   try {
+      if (mode == "--pack") {
+         return pack_corpus(argc, argv);
+      }
+      if (mode == "--corpus") {
+         return solve_corpus(argc, argv);
+      }
+      if (mode == "--validate") {
+         return validate_solutions(argc, argv);
+      }
+      if (mode == "--generate") {
+         return generate(argc, argv);
+      }
+      if (mode == "--shard-run") {
+         return run_shards(argc, argv);
+      }
+      if (mode == "--pipeline") {
+         return pipeline(argc, argv);
+      }
+      if (mode == "--bench-construction") {
+         return bench_construction(argc, argv);
+      }
+      if (mode == "--session") {
+         return play_session(argc, argv);
+      }
+   } catch (std::exception &err) {
+      std::cerr << err.what() << std::endl;
+      return 1;
+   }
+
    if (argc == 2) {
       std::cout << "This is the solution for the required Sudoku puzzle:\n\n";
    } else {
@@ -36,4 +421,4 @@ int main(int argc, char *argv[]) {
    }
    std::cout << "Thank you for playing with me" << std::endl;
    return 0;
-}
\ No newline at end of file
+}